@@ -1,22 +1,274 @@
+#ifdef __linux__
+#define _GNU_SOURCE // sched_setaffinity e cpu_set_t
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <time.h>
 #include <math.h>
 #include <string.h>
+#include <strings.h>
 #include "cJSON.h"
 #include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#ifdef COM_ZLIB
+#include <zlib.h> // entrada .gz: compilar com -DCOM_ZLIB e ligar com -lz
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #ifdef __linux__
 #ifndef CLOCK_MONOTONIC
 #define CLOCK_MONOTONIC 1
 #endif
 #include <time.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #else
 #include <sys/time.h>
 #endif
 
 #define INF INT_MAX
 
+// Camada de alocação dos vetores grandes (vértices, bloco de arestas, estado
+// do Dijkstra): blocos alinhados a 64 bytes (uma linha de cache) e, a partir
+// de 2 MiB, apoiados em páginas enormes para reduzir falhas de TLB. O modo
+// vem da variável de ambiente DIJKSTRA_PAGINAS:
+//   hugetlb - mmap com MAP_HUGETLB (exige páginas reservadas em vm.nr_hugepages)
+//   thp     - mmap + madvise(MADV_HUGEPAGE) (padrão)
+//   normais - só o alinhamento
+// Se o modo pedido falhar, o bloco cai para o próximo da lista.
+#define LINHA_CACHE 64
+#define PAGINA_ENORME (2 * 1024 * 1024)
+
+enum
+{
+    PAGINAS_NORMAIS,
+    PAGINAS_THP,
+    PAGINAS_HUGETLB
+};
+
+const char *nomes_paginas[] = {"páginas normais", "THP (madvise)", "hugetlb"};
+static int modo_paginas = -1;
+long long bytes_por_pagina[3]; // bytes em uso em cada tipo de página
+
+// Contabilidade por categoria: bytes em uso e pico de cada tipo de estrutura
+// (a posição NUM_CATEGORIAS guarda o total)
+enum
+{
+    MEMORIA_GRAFO, // vértices, arestas e componentes
+    MEMORIA_JSON,  // texto do arquivo e árvore do cJSON
+    MEMORIA_BUSCA, // estado do Dijkstra e áreas de trabalho
+    NUM_CATEGORIAS
+};
+
+const char *nomes_categorias[] = {"grafo", "JSON", "busca", "total"};
+long long memoria_atual[NUM_CATEGORIAS + 1];
+long long memoria_pico[NUM_CATEGORIAS + 1];
+
+static void atualizar_pico(int i, long long atual)
+{
+    long long pico = __atomic_load_n(&memoria_pico[i], __ATOMIC_RELAXED);
+    while (atual > pico && !__atomic_compare_exchange_n(&memoria_pico[i], &pico, atual, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+static void contabilizar(int categoria, long long bytes)
+{
+    atualizar_pico(categoria, __atomic_add_fetch(&memoria_atual[categoria], bytes, __ATOMIC_RELAXED));
+    atualizar_pico(NUM_CATEGORIAS, __atomic_add_fetch(&memoria_atual[NUM_CATEGORIAS], bytes, __ATOMIC_RELAXED));
+}
+
+// Os picos passam a contar a partir do uso atual
+void zerar_picos_memoria()
+{
+    for (int i = 0; i <= NUM_CATEGORIAS; i++)
+        memoria_pico[i] = memoria_atual[i];
+}
+
+// Blocos pequenos contabilizados, sem o alinhamento de alocar(): tamanho e
+// categoria ficam nos 16 bytes antes do ponteiro
+#define CABECALHO_PEQUENO 16
+
+void *memoria_malloc(size_t bytes, int categoria)
+{
+    size_t *base = malloc(bytes + CABECALHO_PEQUENO);
+    if (!base)
+        return NULL;
+    base[0] = bytes;
+    base[1] = categoria;
+    contabilizar(categoria, bytes);
+    return (char *)base + CABECALHO_PEQUENO;
+}
+
+void memoria_free(void *p)
+{
+    if (!p)
+        return;
+    size_t *base = (size_t *)((char *)p - CABECALHO_PEQUENO);
+    contabilizar((int)base[1], -(long long)base[0]);
+    free(base);
+}
+
+// Ganchos do cJSON: a árvore do documento entra na categoria JSON
+static void *json_malloc(size_t bytes)
+{
+    return memoria_malloc(bytes, MEMORIA_JSON);
+}
+
+static void json_free(void *p)
+{
+    memoria_free(p);
+}
+
+// Guardado nos 64 bytes antes do ponteiro devolvido
+typedef struct
+{
+    size_t mapeado; // tamanho do mmap (0 se veio de posix_memalign)
+    size_t bytes;
+    int tipo;
+    int categoria;
+} CabecalhoBloco;
+
+int modo_de_paginas()
+{
+    if (modo_paginas < 0)
+    {
+        const char *modo = getenv("DIJKSTRA_PAGINAS");
+        if (modo && strcmp(modo, "hugetlb") == 0)
+            modo_paginas = PAGINAS_HUGETLB;
+        else if (modo && strcmp(modo, "normais") == 0)
+            modo_paginas = PAGINAS_NORMAIS;
+        else
+            modo_paginas = PAGINAS_THP;
+    }
+    return modo_paginas;
+}
+
+#ifdef __linux__
+// mmap anônimo de pelo menos bytes, começando numa fronteira de página enorme
+static char *mapear_paginas(size_t bytes, int tipo, size_t *mapeado)
+{
+    size_t tamanho = (bytes + PAGINA_ENORME - 1) / PAGINA_ENORME * PAGINA_ENORME;
+    if (tipo == PAGINAS_HUGETLB)
+    {
+        void *p = mmap(NULL, tamanho, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p == MAP_FAILED)
+            return NULL;
+        *mapeado = tamanho;
+        return p;
+    }
+    // THP só cobre trechos alinhados a 2 MiB: mapeia com folga e apara as pontas
+    size_t total = tamanho + PAGINA_ENORME;
+    char *bruto = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bruto == MAP_FAILED)
+        return NULL;
+    char *inicio = (char *)(((uintptr_t)bruto + PAGINA_ENORME - 1) & ~(uintptr_t)(PAGINA_ENORME - 1));
+    if (inicio > bruto)
+        munmap(bruto, inicio - bruto);
+    if (bruto + total > inicio + tamanho)
+        munmap(inicio + tamanho, bruto + total - (inicio + tamanho));
+    madvise(inicio, tamanho, MADV_HUGEPAGE);
+    *mapeado = tamanho;
+    return inicio;
+}
+#endif
+
+// Bloco de bytes alinhado a LINHA_CACHE (conteúdo indefinido), contado em
+// categoria; liberar com liberar()
+void *alocar(size_t bytes, int categoria)
+{
+    int tipo = bytes >= PAGINA_ENORME ? modo_de_paginas() : PAGINAS_NORMAIS;
+    size_t total = bytes + LINHA_CACHE;
+    size_t mapeado = 0;
+    char *base = NULL;
+#ifdef __linux__
+    while (tipo != PAGINAS_NORMAIS && !(base = mapear_paginas(total, tipo, &mapeado)))
+        tipo--;
+#else
+    tipo = PAGINAS_NORMAIS;
+#endif
+    if (!base)
+    {
+        void *p;
+        if (posix_memalign(&p, LINHA_CACHE, total) != 0)
+            return NULL;
+        base = p;
+    }
+    CabecalhoBloco *cabecalho = (CabecalhoBloco *)base;
+    cabecalho->mapeado = mapeado;
+    cabecalho->bytes = bytes;
+    cabecalho->tipo = tipo;
+    cabecalho->categoria = categoria;
+    __atomic_add_fetch(&bytes_por_pagina[tipo], (long long)bytes, __ATOMIC_RELAXED);
+    contabilizar(categoria, bytes);
+    return base + LINHA_CACHE;
+}
+
+void *alocar_zerado(size_t bytes, int categoria)
+{
+    char *p = alocar(bytes, categoria);
+    // Páginas recém-mapeadas já vêm zeradas
+    if (p && ((CabecalhoBloco *)(p - LINHA_CACHE))->mapeado == 0)
+        memset(p, 0, bytes);
+    return p;
+}
+
+// Quanto do processo está de fato em páginas enormes transparentes (kB, -1 se
+// não der para ler)
+long paginas_enormes_do_processo()
+{
+    long kb = -1;
+#ifdef __linux__
+    FILE *f = fopen("/proc/self/smaps_rollup", "r");
+    if (!f)
+        return -1;
+    char linha[256];
+    while (fgets(linha, sizeof(linha), f))
+        if (sscanf(linha, "AnonHugePages: %ld kB", &kb) == 1)
+            break;
+    fclose(f);
+#endif
+    return kb;
+}
+
+void mostrar_paginas()
+{
+    const double mib = 1024.0 * 1024.0;
+    printf("🧱 Páginas pedidas: %s; em uso: %.1f MiB hugetlb, %.1f MiB THP, %.1f MiB páginas normais",
+           nomes_paginas[modo_de_paginas()], bytes_por_pagina[PAGINAS_HUGETLB] / mib,
+           bytes_por_pagina[PAGINAS_THP] / mib, bytes_por_pagina[PAGINAS_NORMAIS] / mib);
+    long kb = paginas_enormes_do_processo();
+    if (kb >= 0)
+        printf(" (AnonHugePages: %ld kB)", kb);
+    printf("\n");
+}
+
+void liberar(void *p)
+{
+    if (!p)
+        return;
+    CabecalhoBloco *cabecalho = (CabecalhoBloco *)((char *)p - LINHA_CACHE);
+    __atomic_sub_fetch(&bytes_por_pagina[cabecalho->tipo], (long long)cabecalho->bytes, __ATOMIC_RELAXED);
+    contabilizar(cabecalho->categoria, -(long long)cabecalho->bytes);
+#ifdef __linux__
+    if (cabecalho->mapeado)
+    {
+        munmap(cabecalho, cabecalho->mapeado);
+        return;
+    }
+#endif
+    free(cabecalho);
+}
+
 typedef struct
 {
     int dest;
@@ -33,40 +285,301 @@ typedef struct
 typedef struct
 {
     AdjList *vertices;
+    Edge *edge_pool; // bloco contíguo das listas compactadas (ver compactar_arestas)
     int n;
+    long long m;
+    int min_weight;
+    int max_weight;
+    int directed;
+    // Componentes (fracamente) conexos, calculados no carregamento:
+    // component_vertices[component_start[c] .. component_start[c + 1]) são os
+    // vértices do componente c e local_index[v] a posição de v nessa faixa
+    int *component;
+    int num_components;
+    int *component_start;
+    int *component_vertices;
+    int *local_index;
 } Graph;
 
+#define SETTLED -2
+
+// Estado quente de um vértice, intercalado para que a relaxação toque uma só
+// linha de cache em vez de um vetor por campo: distância, posição no heap
+// (-1 fora dele, SETTLED depois de assentado), carimbo de época (só usado
+// pela área de trabalho) e antecessor
+typedef struct
+{
+    int dist;
+    int pos;
+    unsigned int stamp;
+    int pred;
+} VertexState;
+
 typedef struct
 {
     int *nodes;
-    int *dist;
+    VertexState *state; // chave e posição de cada vértice do heap
     int size;
 } MinHeap;
 
 void init_graph(Graph *g, int n)
 {
     g->n = n;
-    g->vertices = calloc(n, sizeof(AdjList));
+    g->vertices = alocar_zerado(n * sizeof(AdjList), MEMORIA_GRAFO);
+    g->edge_pool = NULL;
+    g->m = 0;
+    g->min_weight = INF;
+    g->max_weight = 0;
+    g->directed = 1;
+    g->component = NULL;
+    g->num_components = 0;
+    g->component_start = NULL;
+    g->component_vertices = NULL;
+    g->local_index = NULL;
+}
+
+void free_components(Graph *g)
+{
+    memoria_free(g->component);
+    memoria_free(g->component_start);
+    memoria_free(g->component_vertices);
+    memoria_free(g->local_index);
+    g->component = NULL;
+    g->num_components = 0;
+    g->component_start = NULL;
+    g->component_vertices = NULL;
+    g->local_index = NULL;
 }
 
 void add_edge(Graph *g, int u, int v, int w)
 {
     AdjList *list = &g->vertices[u];
-    if (list->edge_count == list->edge_capacity)
+    if (list->edge_count >= list->edge_capacity)
     {
-        list->edge_capacity = list->edge_capacity ? list->edge_capacity * 2 : 4;
-        list->edges = realloc(list->edges, list->edge_capacity * sizeof(Edge));
+        // Listas do bloco compactado (capacidade 0) são copiadas antes de crescer
+        int capacidade = list->edge_count ? list->edge_count * 2 : 4;
+        Edge *novas = memoria_malloc(capacidade * sizeof(Edge), MEMORIA_GRAFO);
+        if (list->edge_count > 0)
+            memcpy(novas, list->edges, list->edge_count * sizeof(Edge));
+        if (list->edge_capacity > 0)
+            memoria_free(list->edges);
+        list->edges = novas;
+        list->edge_capacity = capacidade;
     }
     list->edges[list->edge_count++] = (Edge){v, w};
+    g->m++;
+    if (g->component && g->component[u] != g->component[v])
+        free_components(g); // a aresta uniu dois componentes
+    if (w < g->min_weight)
+        g->min_weight = w;
+    if (w > g->max_weight)
+        g->max_weight = w;
 }
 
 void free_graph(Graph *g)
 {
     for (int i = 0; i < g->n; i++)
     {
-        free(g->vertices[i].edges);
+        if (g->vertices[i].edge_capacity > 0)
+            memoria_free(g->vertices[i].edges);
+    }
+    liberar(g->edge_pool);
+    liberar(g->vertices);
+    free_components(g);
+}
+
+// Copia todas as listas de adjacência para um único bloco contíguo (alinhado
+// e em páginas enormes quando possível), na ordem dos vértices, para que a
+// varredura das arestas percorra memória sequencial
+void compactar_arestas(Graph *g)
+{
+    long long total = 0;
+    for (int u = 0; u < g->n; u++)
+        total += g->vertices[u].edge_count;
+    Edge *bloco = alocar((total > 0 ? total : 1) * sizeof(Edge), MEMORIA_GRAFO);
+    long long k = 0;
+    for (int u = 0; u < g->n; u++)
+    {
+        AdjList *list = &g->vertices[u];
+        if (list->edge_count > 0)
+            memcpy(bloco + k, list->edges, list->edge_count * sizeof(Edge));
+        if (list->edge_capacity > 0)
+            memoria_free(list->edges);
+        list->edges = bloco + k;
+        list->edge_capacity = 0;
+        k += list->edge_count;
+    }
+    liberar(g->edge_pool);
+    g->edge_pool = bloco;
+}
+
+static int *copiar_vetor(const int *origem, size_t quantidade)
+{
+    if (!origem)
+        return NULL;
+    int *copia = memoria_malloc(quantidade * sizeof(int), MEMORIA_GRAFO);
+    memcpy(copia, origem, quantidade * sizeof(int));
+    return copia;
+}
+
+// Cópia profunda e compactada de src; as páginas novas são tocadas pela
+// thread que chama (primeiro toque), o que põe a cópia no nó NUMA dela
+void copiar_grafo(Graph *dst, const Graph *src)
+{
+    init_graph(dst, src->n);
+    long long total = 0;
+    for (int u = 0; u < src->n; u++)
+        total += src->vertices[u].edge_count;
+    dst->edge_pool = alocar((total > 0 ? total : 1) * sizeof(Edge), MEMORIA_GRAFO);
+    long long k = 0;
+    for (int u = 0; u < src->n; u++)
+    {
+        AdjList *list = &dst->vertices[u];
+        list->edges = dst->edge_pool + k;
+        list->edge_count = src->vertices[u].edge_count;
+        if (list->edge_count > 0)
+            memcpy(list->edges, src->vertices[u].edges, list->edge_count * sizeof(Edge));
+        k += list->edge_count;
+    }
+    dst->m = src->m;
+    dst->min_weight = src->min_weight;
+    dst->max_weight = src->max_weight;
+    dst->directed = src->directed;
+    if (src->component)
+    {
+        dst->num_components = src->num_components;
+        dst->component = copiar_vetor(src->component, src->n);
+        dst->component_start = copiar_vetor(src->component_start, src->num_components + 1);
+        dst->component_vertices = copiar_vetor(src->component_vertices, src->n);
+        dst->local_index = copiar_vetor(src->local_index, src->n);
+    }
+}
+
+// Arco lido de um arquivo ou gerado, antes de virar lista de adjacência
+typedef struct
+{
+    int u;
+    int v;
+    int weight;
+} Arc;
+
+typedef struct
+{
+    Arc *arcs;
+    long long count;
+    long long capacity;
+} ArcBuffer;
+
+void arc_buffer_push(ArcBuffer *b, int u, int v, int w)
+{
+    if (b->count == b->capacity)
+    {
+        long long capacidade = b->capacity ? b->capacity * 2 : 1024;
+        Arc *novos = memoria_malloc(capacidade * sizeof(Arc), MEMORIA_JSON);
+        if (b->count > 0)
+            memcpy(novos, b->arcs, b->count * sizeof(Arc));
+        memoria_free(b->arcs);
+        b->arcs = novos;
+        b->capacity = capacidade;
+    }
+    b->arcs[b->count++] = (Arc){u, v, w};
+}
+
+void arc_buffer_free(ArcBuffer *b)
+{
+    memoria_free(b->arcs);
+    b->arcs = NULL;
+    b->count = b->capacity = 0;
+}
+
+static int uf_find(int *parent, int x)
+{
+    while (parent[x] != x)
+    {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+// Rotula os componentes com union-find (ignorando a direção das arestas:
+// vértices em componentes diferentes nunca se alcançam)
+void compute_components(Graph *g)
+{
+    int n = g->n;
+    free_components(g);
+    int *parent = malloc(n * sizeof(int));
+    int *size = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++)
+    {
+        parent[i] = i;
+        size[i] = 1;
+    }
+    for (int u = 0; u < n; u++)
+    {
+        for (int i = 0; i < g->vertices[u].edge_count; i++)
+        {
+            int a = uf_find(parent, u);
+            int b = uf_find(parent, g->vertices[u].edges[i].dest);
+            if (a == b)
+                continue;
+            if (size[a] < size[b])
+            {
+                int t = a;
+                a = b;
+                b = t;
+            }
+            parent[b] = a;
+            size[a] += size[b];
+        }
+    }
+
+    g->component = memoria_malloc(n * sizeof(int), MEMORIA_GRAFO);
+    int *rotulo = size; // reaproveitado: rótulo de cada raiz
+    for (int i = 0; i < n; i++)
+        rotulo[i] = -1;
+    int c = 0;
+    for (int v = 0; v < n; v++)
+    {
+        int r = uf_find(parent, v);
+        if (rotulo[r] < 0)
+            rotulo[r] = c++;
+        g->component[v] = rotulo[r];
+    }
+    free(parent);
+    free(size);
+
+    g->num_components = c;
+    g->component_start = memoria_malloc((c + 1) * sizeof(int), MEMORIA_GRAFO);
+    memset(g->component_start, 0, (c + 1) * sizeof(int));
+    g->component_vertices = memoria_malloc(n * sizeof(int), MEMORIA_GRAFO);
+    g->local_index = memoria_malloc(n * sizeof(int), MEMORIA_GRAFO);
+    for (int v = 0; v < n; v++)
+        g->component_start[g->component[v] + 1]++;
+    for (int k = 0; k < c; k++)
+        g->component_start[k + 1] += g->component_start[k];
+    // Distribui em ordem crescente de vértice dentro de cada componente
+    int *cursor = malloc(c * sizeof(int));
+    memcpy(cursor, g->component_start, c * sizeof(int));
+    for (int v = 0; v < n; v++)
+    {
+        int k = g->component[v];
+        g->local_index[v] = cursor[k] - g->component_start[k];
+        g->component_vertices[cursor[k]++] = v;
     }
-    free(g->vertices);
+    free(cursor);
+}
+
+// Vértices em componentes diferentes não se alcançam
+int same_component(Graph *g, int u, int v)
+{
+    return !g->component || g->component[u] == g->component[v];
+}
+
+int numero_de_threads()
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
 }
 
 void swap(int *a, int *b)
@@ -76,223 +589,5150 @@ void swap(int *a, int *b)
     *b = t;
 }
 
-void min_heapify(MinHeap *h, int i, int *pos)
+// Construção paralela do bloco de arestas a partir de buffers de arcos:
+// graus contados com incrementos atômicos, deslocamentos por soma de prefixos
+// em blocos de vértices, arcos espalhados com cursores atômicos e, se pedido,
+// cada lista ordenada por destino
+typedef struct
+{
+    Graph *g;
+    ArcBuffer *buffers;
+    int num_buffers;
+    long long *buffer_start; // índice global do primeiro arco de cada buffer
+    long long total_arcs;
+    int simetrico;
+    int ordenar;
+    int nthreads;
+    int *grau;
+    long long *inicio; // n + 1 deslocamentos
+    long long *cursor;
+    long long *soma_bloco;
+    Edge *bloco;
+    int proximo_vertice; // distribuição dinâmica da ordenação
+    pthread_barrier_t barrier;
+} GraphBuild;
+
+typedef struct
+{
+    GraphBuild *b;
+    int id;
+    int min_weight;
+    int max_weight;
+} GraphBuildWorker;
+
+#define BLOCO_ORDENACAO 1024
+
+static int comparar_arestas(const void *a, const void *b)
+{
+    const Edge *x = a, *y = b;
+    if (x->dest != y->dest)
+        return x->dest < y->dest ? -1 : 1;
+    return (x->weight > y->weight) - (x->weight < y->weight);
+}
+
+// Buffer que contém o arco de índice global i
+static int buffer_do_arco(const GraphBuild *b, long long i)
+{
+    int k = 0;
+    while (k < b->num_buffers - 1 && b->buffer_start[k + 1] <= i)
+        k++;
+    return k;
+}
+
+static void *graph_build_worker(void *arg)
+{
+    GraphBuildWorker *w = arg;
+    GraphBuild *b = w->b;
+    Graph *g = b->g;
+    int t = w->id, T = b->nthreads;
+    long long ini = b->total_arcs * t / T, fim = b->total_arcs * (t + 1) / T;
+    int v_ini = (int)((long long)g->n * t / T), v_fim = (int)((long long)g->n * (t + 1) / T);
+
+    for (long long i = ini, k = buffer_do_arco(b, ini); i < fim; i++)
+    {
+        while (i >= b->buffer_start[k + 1])
+            k++;
+        Arc a = b->buffers[k].arcs[i - b->buffer_start[k]];
+        if (T == 1)
+        {
+            b->grau[a.u]++;
+            b->grau[a.v] += b->simetrico;
+            continue;
+        }
+        __atomic_fetch_add(&b->grau[a.u], 1, __ATOMIC_RELAXED);
+        if (b->simetrico)
+            __atomic_fetch_add(&b->grau[a.v], 1, __ATOMIC_RELAXED);
+    }
+    pthread_barrier_wait(&b->barrier);
+
+    long long soma = 0;
+    for (int u = v_ini; u < v_fim; u++)
+        soma += b->grau[u];
+    b->soma_bloco[t] = soma;
+    pthread_barrier_wait(&b->barrier);
+    if (t == 0)
+    {
+        long long acumulado = 0;
+        for (int k = 0; k < T; k++)
+        {
+            long long s = b->soma_bloco[k];
+            b->soma_bloco[k] = acumulado;
+            acumulado += s;
+        }
+        b->inicio[g->n] = acumulado;
+        b->bloco = alocar((acumulado > 0 ? acumulado : 1) * sizeof(Edge), MEMORIA_GRAFO);
+    }
+    pthread_barrier_wait(&b->barrier);
+    soma = b->soma_bloco[t];
+    for (int u = v_ini; u < v_fim; u++)
+    {
+        b->inicio[u] = b->cursor[u] = soma;
+        soma += b->grau[u];
+    }
+    pthread_barrier_wait(&b->barrier);
+
+    Edge *bloco = b->bloco;
+    for (long long i = ini, k = buffer_do_arco(b, ini); i < fim; i++)
+    {
+        while (i >= b->buffer_start[k + 1])
+            k++;
+        Arc a = b->buffers[k].arcs[i - b->buffer_start[k]];
+        if (T == 1)
+        {
+            bloco[b->cursor[a.u]++] = (Edge){a.v, a.weight};
+            if (b->simetrico)
+                bloco[b->cursor[a.v]++] = (Edge){a.u, a.weight};
+        }
+        else
+        {
+            bloco[__atomic_fetch_add(&b->cursor[a.u], 1, __ATOMIC_RELAXED)] = (Edge){a.v, a.weight};
+            if (b->simetrico)
+                bloco[__atomic_fetch_add(&b->cursor[a.v], 1, __ATOMIC_RELAXED)] = (Edge){a.u, a.weight};
+        }
+        if (a.weight < w->min_weight)
+            w->min_weight = a.weight;
+        if (a.weight > w->max_weight)
+            w->max_weight = a.weight;
+    }
+
+    if (b->ordenar)
+    {
+        pthread_barrier_wait(&b->barrier);
+        int u0;
+        while ((u0 = __atomic_fetch_add(&b->proximo_vertice, BLOCO_ORDENACAO, __ATOMIC_RELAXED)) < g->n)
+            for (int u = u0; u < u0 + BLOCO_ORDENACAO && u < g->n; u++)
+            {
+                Edge *lista = bloco + b->inicio[u];
+                long long grau = b->inicio[u + 1] - b->inicio[u], i = 1;
+                while (i < grau && comparar_arestas(&lista[i - 1], &lista[i]) <= 0)
+                    i++;
+                if (i < grau) // só ordena listas que ainda não estão em ordem
+                    qsort(lista, grau, sizeof(Edge), comparar_arestas);
+            }
+    }
+    return NULL;
+}
+
+// Monta as listas de adjacência de g (recém-criado com init_graph) direto no
+// bloco contíguo. Com simetrico, cada arco u->v também gera v->u. Com várias
+// threads a ordem dentro de cada lista depende do escalonamento; com ordenar,
+// cada lista fica em ordem crescente de destino.
+void build_graph_from_arcs(Graph *g, ArcBuffer *buffers, int num_buffers, int simetrico, int ordenar)
+{
+    GraphBuild b = {.g = g,
+                    .buffers = buffers,
+                    .num_buffers = num_buffers,
+                    .simetrico = simetrico,
+                    .ordenar = ordenar,
+                    .nthreads = numero_de_threads()};
+    b.buffer_start = malloc((num_buffers + 1) * sizeof(long long));
+    for (int k = 0; k < num_buffers; k++)
+    {
+        b.buffer_start[k] = b.total_arcs;
+        b.total_arcs += buffers[k].count;
+    }
+    b.buffer_start[num_buffers] = b.total_arcs;
+    // Threads só compensam com bastante trabalho por thread
+    long long por_thread = (b.total_arcs + g->n) / 65536 + 1;
+    if (b.nthreads > por_thread)
+        b.nthreads = (int)por_thread;
+    b.grau = calloc(g->n + 1, sizeof(int));
+    b.inicio = malloc((g->n + 1) * sizeof(long long));
+    b.cursor = malloc((g->n + 1) * sizeof(long long));
+    b.soma_bloco = malloc(b.nthreads * sizeof(long long));
+    pthread_barrier_init(&b.barrier, NULL, b.nthreads);
+
+    GraphBuildWorker *workers = malloc(b.nthreads * sizeof(GraphBuildWorker));
+    pthread_t *threads = malloc(b.nthreads * sizeof(pthread_t));
+    for (int t = 0; t < b.nthreads; t++)
+        workers[t] = (GraphBuildWorker){&b, t, INF, 0};
+    for (int t = 1; t < b.nthreads; t++)
+        pthread_create(&threads[t], NULL, graph_build_worker, &workers[t]);
+    graph_build_worker(&workers[0]);
+    for (int t = 1; t < b.nthreads; t++)
+        pthread_join(threads[t], NULL);
+
+    for (int t = 0; t < b.nthreads; t++)
+    {
+        if (workers[t].min_weight < g->min_weight)
+            g->min_weight = workers[t].min_weight;
+        if (workers[t].max_weight > g->max_weight)
+            g->max_weight = workers[t].max_weight;
+    }
+    for (int u = 0; u < g->n; u++)
+    {
+        g->vertices[u].edges = b.bloco + b.inicio[u];
+        g->vertices[u].edge_count = (int)(b.inicio[u + 1] - b.inicio[u]);
+        g->vertices[u].edge_capacity = 0;
+    }
+    liberar(g->edge_pool);
+    g->edge_pool = b.bloco;
+    g->m = b.inicio[g->n];
+
+    pthread_barrier_destroy(&b.barrier);
+    free(workers);
+    free(threads);
+    free(b.buffer_start);
+    free(b.grau);
+    free(b.inicio);
+    free(b.cursor);
+    free(b.soma_bloco);
+}
+
+void min_heapify(MinHeap *h, int i)
 {
     int smallest = i;
     int l = 2 * i + 1;
     int r = 2 * i + 2;
-    if (l < h->size && h->dist[h->nodes[l]] < h->dist[h->nodes[smallest]])
+    VertexState *st = h->state;
+    if (l < h->size && st[h->nodes[l]].dist < st[h->nodes[smallest]].dist)
         smallest = l;
-    if (r < h->size && h->dist[h->nodes[r]] < h->dist[h->nodes[smallest]])
+    if (r < h->size && st[h->nodes[r]].dist < st[h->nodes[smallest]].dist)
         smallest = r;
     if (smallest != i)
     {
-        pos[h->nodes[i]] = smallest;
-        pos[h->nodes[smallest]] = i;
+        st[h->nodes[i]].pos = smallest;
+        st[h->nodes[smallest]].pos = i;
         swap(&h->nodes[i], &h->nodes[smallest]);
-        min_heapify(h, smallest, pos);
+        min_heapify(h, smallest);
     }
 }
 
-int extract_min(MinHeap *h, int *pos)
+int extract_min(MinHeap *h)
 {
     int root = h->nodes[0];
     h->nodes[0] = h->nodes[h->size - 1];
-    pos[h->nodes[0]] = 0;
+    h->state[h->nodes[0]].pos = 0;
     h->size--;
-    min_heapify(h, 0, pos);
+    min_heapify(h, 0);
     return root;
 }
 
-void decrease_key(MinHeap *h, int v, int new_dist, int *pos)
+void decrease_key(MinHeap *h, int v, int new_dist)
 {
-    int i = pos[v];
-    h->dist[v] = new_dist;
-    while (i > 0 && h->dist[h->nodes[i]] < h->dist[h->nodes[(i - 1) / 2]])
+    VertexState *st = h->state;
+    int i = st[v].pos;
+    st[v].dist = new_dist;
+    while (i > 0 && st[h->nodes[i]].dist < st[h->nodes[(i - 1) / 2]].dist)
     {
         int parent = (i - 1) / 2;
-        pos[h->nodes[i]] = parent;
-        pos[h->nodes[parent]] = i;
+        st[h->nodes[i]].pos = parent;
+        st[h->nodes[parent]].pos = i;
         swap(&h->nodes[i], &h->nodes[parent]);
         i = parent;
     }
 }
 
-int *dijkstra(Graph *g, int start)
+void heap_insert(MinHeap *h, int v)
 {
-    int n = g->n;
-    int *dist = malloc(n * sizeof(int));
-    int *visited = calloc(n, sizeof(int));
-    int *pos = malloc(n * sizeof(int));
+    h->nodes[h->size] = v;
+    h->state[v].pos = h->size;
+    h->size++;
+    decrease_key(h, v, h->state[v].dist);
+}
+
+// Vértices do componente de v, na ordem das saídas por componente (NULL se o
+// grafo não tem componentes rotulados: a ordem é a dos índices)
+const int *componente_de(const Graph *g, int v)
+{
+    return g->component ? g->component_vertices + g->component_start[g->component[v]] : NULL;
+}
+
+// Posição de v nas saídas por componente
+static inline int indice_local(const Graph *g, int v)
+{
+    return g->local_index ? g->local_index[v] : v;
+}
+
+static inline int tamanho_componente(const Graph *g, int v)
+{
+    if (!g->component)
+        return g->n;
+    int c = g->component[v];
+    return g->component_start[c + 1] - g->component_start[c];
+}
+
+// Dijkstra restrito ao componente de start: aloca e inicializa só os cn
+// vértices dele (*cn_out). Devolve o estado final, que o chamador libera com
+// liberar(): st[i] vale para o vértice componente_de(g, start)[i], com pred
+// em índices globais (-1 se não houver).
+static VertexState *buscar_no_componente(Graph *g, int start, int *cn_out)
+{
+    const int *membros = componente_de(g, start);
+    int cn = tamanho_componente(g, start);
+    VertexState *st = alocar(cn * sizeof(VertexState), MEMORIA_BUSCA);
     MinHeap heap;
-    heap.size = n;
-    heap.nodes = malloc(n * sizeof(int));
-    heap.dist = malloc(n * sizeof(int));
+    heap.size = cn;
+    heap.nodes = alocar(cn * sizeof(int), MEMORIA_BUSCA);
+    heap.state = st;
 
-    for (int i = 0; i < n; i++)
+    for (int i = 0; i < cn; i++)
     {
-        dist[i] = INF;
-        heap.dist[i] = INF;
+        st[i].dist = INF;
+        st[i].pos = i;
+        st[i].pred = -1;
         heap.nodes[i] = i;
-        pos[i] = i;
     }
-
-    dist[start] = 0;
-    heap.dist[start] = 0;
-    decrease_key(&heap, start, 0, pos);
+    decrease_key(&heap, indice_local(g, start), 0);
 
     while (heap.size > 0)
     {
-        int u = extract_min(&heap, pos);
-        if (dist[u] == INF)
+        int lu = extract_min(&heap);
+        int du = st[lu].dist;
+        if (du == INF)
             break;
-        visited[u] = 1;
+        st[lu].pos = SETTLED;
+        int u = membros ? membros[lu] : lu;
 
         for (int i = 0; i < g->vertices[u].edge_count; i++)
         {
             int v = g->vertices[u].edges[i].dest;
             int w = g->vertices[u].edges[i].weight;
+            int lv = indice_local(g, v);
 
-            if (!visited[v] && dist[u] != INF && dist[v] > dist[u] + w)
+            if (st[lv].pos != SETTLED && st[lv].dist > du + w)
             {
-                dist[v] = dist[u] + w;
-                decrease_key(&heap, v, dist[v], pos);
+                st[lv].pred = u;
+                decrease_key(&heap, lv, du + w);
             }
         }
     }
+    liberar(heap.nodes);
+    *cn_out = cn;
+    return st;
+}
+
+// Consulta por componente: dist[i] (o vetor devolvido) e pred[i] (se pred
+// não for NULL, com espaço para cn inteiros) valem para o vértice
+// componente_de(g, start)[i]; pred guarda índices globais (-1 se não houver).
+// Custa só o componente de start.
+int *dijkstra_componente(Graph *g, int start, int *pred, int *cn_out)
+{
+    int cn;
+    VertexState *st = buscar_no_componente(g, start, &cn);
+    int *dist = malloc(cn * sizeof(int));
+    for (int i = 0; i < cn; i++)
+    {
+        dist[i] = st[i].dist;
+        if (pred)
+            pred[i] = st[i].pred;
+    }
+    liberar(st);
+    *cn_out = cn;
+    return dist;
+}
+
+// Versão com vetores de tamanho n (INF / -1 fora do componente de start),
+// só para quem precisa do vetor completo (conferências, SSSP dinâmico): a
+// busca custa o componente e preencher a saída, O(n). Se pred não for NULL,
+// preenche a árvore de caminhos mínimos: pred[v] é o antecessor de v no
+// caminho a partir de start
+int *dijkstra_pred(Graph *g, int start, int *pred)
+{
+    int n = g->n, cn;
+    const int *membros = componente_de(g, start);
+    VertexState *st = buscar_no_componente(g, start, &cn);
+    int *dist = malloc(n * sizeof(int));
+    if (membros)
+        for (int v = 0; v < n; v++)
+        {
+            dist[v] = INF;
+            if (pred)
+                pred[v] = -1;
+        }
+    for (int i = 0; i < cn; i++)
+    {
+        int v = membros ? membros[i] : i;
+        dist[v] = st[i].dist;
+        if (pred)
+            pred[v] = st[i].pred;
+    }
+    liberar(st);
+    return dist;
+}
+
+int *dijkstra(Graph *g, int start)
+{
+    return dijkstra_pred(g, start, NULL);
+}
+
+// Reconstrói o caminho start -> target em buffer, em O(tamanho do caminho).
+// Retorna o número de vértices do caminho (0 se target for inalcançável); se
+// o retorno for maior que capacity, buffer não foi preenchido.
+int extract_path(const int *pred, int start, int target, int *buffer, int capacity)
+{
+    int len = 1;
+    int v = target;
+    while (v != start && pred[v] >= 0)
+    {
+        v = pred[v];
+        len++;
+    }
+    if (v != start)
+        return 0;
+    if (len > capacity)
+        return len;
+    v = target;
+    for (int i = len - 1; i >= 0; i--)
+    {
+        buffer[i] = v;
+        v = pred[v];
+    }
+    return len;
+}
+
+// Área de trabalho do Dijkstra, dimensionada uma vez por grafo e reaproveitada
+// entre consultas (uma por thread). O estado de v só vale com
+// state[v].stamp == epoch: começar uma consulta nova é incrementar epoch, sem
+// malloc nem reescrever vetores de tamanho n.
+typedef struct EquipeHubs EquipeHubs;
+
+typedef struct
+{
+    int n;
+    unsigned int epoch;
+    VertexState *state;
+    MinHeap heap;
+    EquipeHubs *equipe; // divide a relaxação dos hubs entre threads (NULL: serial)
+} DijkstraWorkspace;
+
+void dijkstra_workspace_init(DijkstraWorkspace *ws, int n)
+{
+    ws->n = n;
+    ws->epoch = 0;
+    ws->state = alocar_zerado(n * sizeof(VertexState), MEMORIA_BUSCA);
+    ws->heap.nodes = alocar(n * sizeof(int), MEMORIA_BUSCA);
+    ws->heap.state = ws->state;
+    ws->heap.size = 0;
+    ws->equipe = NULL;
+}
+
+void dijkstra_workspace_free(DijkstraWorkspace *ws)
+{
+    liberar(ws->state);
+    liberar(ws->heap.nodes);
+}
+
+void dijkstra_workspace_reset(DijkstraWorkspace *ws)
+{
+    if (++ws->epoch == 0)
+    {
+        // Volta do contador: única vez em que o vetor inteiro é limpo
+        for (int v = 0; v < ws->n; v++)
+            ws->state[v].stamp = 0;
+        ws->epoch = 1;
+    }
+    ws->heap.size = 0;
+}
+
+// Distância de v na última consulta (INF se v não foi alcançado)
+int workspace_dist(const DijkstraWorkspace *ws, int v)
+{
+    return ws->state[v].stamp == ws->epoch ? ws->state[v].dist : INF;
+}
+
+// Distâncias da última consulta (a partir de start) no componente de start,
+// na ordem de componente_de(); só esse trecho pode ter sido alcançado, então
+// não é preciso percorrer os n vértices. Retorna o tamanho do componente e,
+// em *maior, a maior distância finita.
+int workspace_componente(const DijkstraWorkspace *ws, const Graph *g, int start, int *dist, int *maior)
+{
+    const int *membros = componente_de(g, start);
+    int cn = tamanho_componente(g, start);
+    *maior = 0;
+    for (int i = 0; i < cn; i++)
+    {
+        int d = workspace_dist(ws, membros ? membros[i] : i);
+        if (dist)
+            dist[i] = d;
+        if (d != INF && d > *maior)
+            *maior = d;
+    }
+    return cn;
+}
+
+// Caminho start -> target da última consulta, como em extract_path()
+int workspace_path(const DijkstraWorkspace *ws, int start, int target, int *buffer, int capacity)
+{
+    if (workspace_dist(ws, target) == INF)
+        return 0;
+    int len = 1;
+    for (int v = target; v != start; v = ws->state[v].pred)
+        len++;
+    if (len > capacity)
+        return len;
+    int v = target;
+    for (int i = len - 1; i >= 0; i--)
+    {
+        buffer[i] = v;
+        v = ws->state[v].pred;
+    }
+    return len;
+}
+
+// Coloca v como origem com distância d (várias origens são permitidas)
+void dijkstra_workspace_seed(DijkstraWorkspace *ws, int v, int d)
+{
+    VertexState *sv = &ws->state[v];
+    if (sv->stamp != ws->epoch)
+    {
+        sv->stamp = ws->epoch;
+        sv->dist = d;
+        sv->pred = -1;
+        heap_insert(&ws->heap, v);
+    }
+    else if (sv->pos != SETTLED && d < sv->dist)
+    {
+        sv->pred = -1;
+        decrease_key(&ws->heap, v, d);
+    }
+}
+
+static void dijkstra_workspace_relax(DijkstraWorkspace *ws, int u, int v, int nd)
+{
+    VertexState *sv = &ws->state[v];
+    if (sv->stamp != ws->epoch)
+    {
+        sv->stamp = ws->epoch;
+        sv->dist = nd;
+        sv->pred = u;
+        heap_insert(&ws->heap, v);
+    }
+    else if (sv->pos != SETTLED && nd < sv->dist)
+    {
+        sv->pred = u;
+        decrease_key(&ws->heap, v, nd);
+    }
+}
+
+// Relaxação das listas longas (hubs, grafos densos): os vizinhos são lidos em
+// vetores de 8 (AVX2) ou 16 (AVX-512), o estado deles é buscado com gather e
+// só as faixas em que a distância melhora passam pelo heap. Listas curtas
+// usam o laço escalar com prefetch alguns vizinhos à frente.
+#define LISTA_LONGA 64
+#define DISTANCIA_PREFETCH 8
+
+#if defined(__x86_64__) || defined(__i386__)
+// Campos de VertexState como índices de int para o gather
+#define CAMPO_DIST 0
+#define CAMPO_POS 1
+#define CAMPO_STAMP 2
+
+__attribute__((target("avx2"))) static int relaxar_lista_avx2(DijkstraWorkspace *ws, int u, int du, const Edge *e, int grau)
+{
+    const int *base = (const int *)ws->state;
+    const __m256i separar = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256i epoch = _mm256_set1_epi32((int)ws->epoch);
+    const __m256i assentado = _mm256_set1_epi32(SETTLED);
+    const __m256i vdu = _mm256_set1_epi32(du);
+    int i = 0;
+    for (; i + 8 <= grau; i += 8)
+    {
+        // {dest, weight} intercalados -> vetor de destinos e vetor de pesos
+        __m256i a = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)(e + i)), separar);
+        __m256i b = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)(e + i + 4)), separar);
+        __m256i dest = _mm256_permute2x128_si256(a, b, 0x20);
+        __m256i cand = _mm256_add_epi32(vdu, _mm256_permute2x128_si256(a, b, 0x31));
+        __m256i idx = _mm256_slli_epi32(dest, 2);
+        __m256i stamp = _mm256_i32gather_epi32(base + CAMPO_STAMP, idx, 4);
+        __m256i dist = _mm256_i32gather_epi32(base + CAMPO_DIST, idx, 4);
+        __m256i pos = _mm256_i32gather_epi32(base + CAMPO_POS, idx, 4);
+        __m256i novo = _mm256_xor_si256(_mm256_cmpeq_epi32(stamp, epoch), _mm256_set1_epi32(-1));
+        __m256i melhora = _mm256_andnot_si256(_mm256_cmpeq_epi32(pos, assentado), _mm256_cmpgt_epi32(dist, cand));
+        int mascara = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_or_si256(novo, melhora)));
+        if (!mascara)
+            continue;
+        int d[8], c[8];
+        _mm256_storeu_si256((__m256i *)d, dest);
+        _mm256_storeu_si256((__m256i *)c, cand);
+        // Faixas candidatas passam pela relaxação escalar, que também
+        // resolve destinos repetidos dentro do mesmo vetor
+        while (mascara)
+        {
+            int j = __builtin_ctz(mascara);
+            dijkstra_workspace_relax(ws, u, d[j], c[j]);
+            mascara &= mascara - 1;
+        }
+    }
+    return i;
+}
+
+__attribute__((target("avx512f"))) static int relaxar_lista_avx512(DijkstraWorkspace *ws, int u, int du, const Edge *e, int grau)
+{
+    const int *base = (const int *)ws->state;
+    const __m512i pares = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i impares = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    const __m512i epoch = _mm512_set1_epi32((int)ws->epoch);
+    const __m512i assentado = _mm512_set1_epi32(SETTLED);
+    const __m512i vdu = _mm512_set1_epi32(du);
+    int i = 0;
+    for (; i + 16 <= grau; i += 16)
+    {
+        __m512i a = _mm512_loadu_si512(e + i);
+        __m512i b = _mm512_loadu_si512(e + i + 8);
+        __m512i dest = _mm512_permutex2var_epi32(a, pares, b);
+        __m512i cand = _mm512_add_epi32(vdu, _mm512_permutex2var_epi32(a, impares, b));
+        __m512i idx = _mm512_slli_epi32(dest, 2);
+        __m512i stamp = _mm512_i32gather_epi32(idx, base + CAMPO_STAMP, 4);
+        __mmask16 novo = _mm512_cmpneq_epi32_mask(stamp, epoch);
+        __m512i dist = _mm512_mask_i32gather_epi32(cand, (__mmask16)~novo, idx, base + CAMPO_DIST, 4);
+        __m512i pos = _mm512_mask_i32gather_epi32(assentado, (__mmask16)~novo, idx, base + CAMPO_POS, 4);
+        __mmask16 melhora = _mm512_cmpneq_epi32_mask(pos, assentado) & _mm512_cmpgt_epi32_mask(dist, cand);
+        unsigned mascara = novo | melhora;
+        if (!mascara)
+            continue;
+        int d[16], c[16];
+        _mm512_storeu_si512(d, dest);
+        _mm512_storeu_si512(c, cand);
+        while (mascara)
+        {
+            int j = __builtin_ctz(mascara);
+            dijkstra_workspace_relax(ws, u, d[j], c[j]);
+            mascara &= mascara - 1;
+        }
+    }
+    return i;
+}
+#endif
+
+// Relaxa o maior prefixo da lista que cabe em vetores; retorna quantas
+// arestas tratou (0 sem AVX2)
+static int relaxar_lista_vetorial(DijkstraWorkspace *ws, int u, int du, const Edge *e, int grau)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx512f"))
+        return relaxar_lista_avx512(ws, u, du, e, grau);
+    if (__builtin_cpu_supports("avx2"))
+        return relaxar_lista_avx2(ws, u, du, e, grau);
+#endif
+    return 0;
+}
+
+// Relaxação de um hub dividida entre uma equipe de threads persistentes: cada
+// thread varre uma fatia fixa da lista de u, só lendo o estado, e anota os
+// índices das arestas que melhoram algum vizinho. Depois a thread da consulta
+// aplica as listas em ordem, pelo mesmo dijkstra_workspace_relax do caminho
+// serial; o resultado (dist e pred) é idêntico ao da relaxação serial.
+#define GIROS_ANTES_DE_DORMIR (1 << 14)
+
+typedef struct
+{
+    int *arestas;
+    int tamanho;
+    int capacidade;
+} ListaMelhorias;
+
+typedef struct
+{
+    EquipeHubs *equipe;
+    int id;
+    pthread_t thread;
+} MembroEquipe;
+
+struct EquipeHubs
+{
+    int nthreads;
+    int limiar; // grau mínimo para dividir a relaxação
+    MembroEquipe *membros;
+    ListaMelhorias *listas; // uma por thread
+    pthread_mutex_t lock;
+    pthread_cond_t acordar;
+    unsigned int geracao; // muda a cada hub publicado
+    int dormindo;
+    int restantes; // threads auxiliares que ainda não terminaram a fatia
+    int encerrar;
+    // hub atual
+    const DijkstraWorkspace *ws;
+    const Edge *e;
+    int du;
+    int grau;
+    long long divididos; // hubs relaxados pela equipe
+};
+
+static void lista_melhorias_push(ListaMelhorias *l, int i)
+{
+    if (l->tamanho == l->capacidade)
+    {
+        l->capacidade = l->capacidade ? l->capacidade * 2 : 256;
+        l->arestas = realloc(l->arestas, l->capacidade * sizeof(int));
+    }
+    l->arestas[l->tamanho++] = i;
+}
+
+static void varrer_fatia(EquipeHubs *eq, int id)
+{
+    const VertexState *state = eq->ws->state;
+    unsigned int epoch = eq->ws->epoch;
+    const Edge *e = eq->e;
+    int du = eq->du;
+    int inicio = (int)((long long)eq->grau * id / eq->nthreads);
+    int fim = (int)((long long)eq->grau * (id + 1) / eq->nthreads);
+    ListaMelhorias *l = &eq->listas[id];
+    for (int i = inicio; i < fim; i++)
+    {
+        if (i + DISTANCIA_PREFETCH < fim)
+            __builtin_prefetch(&state[e[i + DISTANCIA_PREFETCH].dest]);
+        const VertexState *sv = &state[e[i].dest];
+        if (sv->stamp != epoch || (sv->pos != SETTLED && du + e[i].weight < sv->dist))
+            lista_melhorias_push(l, i);
+    }
+}
+
+static void espera_curta(int giro)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (giro < 64)
+    {
+        _mm_pause();
+        return;
+    }
+#endif
+    (void)giro;
+    sched_yield();
+}
+
+static void *membro_equipe(void *arg)
+{
+    MembroEquipe *m = arg;
+    EquipeHubs *eq = m->equipe;
+    unsigned int vista = 0;
+    while (1)
+    {
+        // Gira um pouco esperando o próximo hub e, se ele não vier, dorme
+        int giro = 0;
+        while (__atomic_load_n(&eq->geracao, __ATOMIC_ACQUIRE) == vista && giro < GIROS_ANTES_DE_DORMIR)
+            espera_curta(giro++);
+        if (__atomic_load_n(&eq->geracao, __ATOMIC_ACQUIRE) == vista)
+        {
+            pthread_mutex_lock(&eq->lock);
+            __atomic_add_fetch(&eq->dormindo, 1, __ATOMIC_SEQ_CST);
+            while (__atomic_load_n(&eq->geracao, __ATOMIC_SEQ_CST) == vista)
+                pthread_cond_wait(&eq->acordar, &eq->lock);
+            __atomic_sub_fetch(&eq->dormindo, 1, __ATOMIC_SEQ_CST);
+            pthread_mutex_unlock(&eq->lock);
+        }
+        vista = __atomic_load_n(&eq->geracao, __ATOMIC_ACQUIRE);
+        if (eq->encerrar)
+            break;
+        varrer_fatia(eq, m->id);
+        __atomic_sub_fetch(&eq->restantes, 1, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+static void publicar_geracao(EquipeHubs *eq)
+{
+    __atomic_add_fetch(&eq->geracao, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&eq->dormindo, __ATOMIC_SEQ_CST) > 0)
+    {
+        pthread_mutex_lock(&eq->lock);
+        pthread_cond_broadcast(&eq->acordar);
+        pthread_mutex_unlock(&eq->lock);
+    }
+}
+
+// Cria a equipe com nthreads threads (contando a da consulta); limiar <= 0
+// usa o padrão. Com uma única thread a equipe não é criada e retorna 0.
+int equipe_hubs_init(EquipeHubs *eq, int nthreads, int limiar)
+{
+    memset(eq, 0, sizeof(*eq));
+    if (nthreads < 2)
+        return 0;
+    eq->nthreads = nthreads;
+    eq->limiar = limiar > 0 ? limiar : 1024;
+    eq->membros = calloc(nthreads, sizeof(MembroEquipe));
+    eq->listas = calloc(nthreads, sizeof(ListaMelhorias));
+    pthread_mutex_init(&eq->lock, NULL);
+    pthread_cond_init(&eq->acordar, NULL);
+    for (int t = 1; t < nthreads; t++)
+    {
+        eq->membros[t].equipe = eq;
+        eq->membros[t].id = t;
+        pthread_create(&eq->membros[t].thread, NULL, membro_equipe, &eq->membros[t]);
+    }
+    return 1;
+}
+
+void equipe_hubs_free(EquipeHubs *eq)
+{
+    if (eq->nthreads < 2)
+        return;
+    eq->encerrar = 1;
+    publicar_geracao(eq);
+    for (int t = 1; t < eq->nthreads; t++)
+        pthread_join(eq->membros[t].thread, NULL);
+    for (int t = 0; t < eq->nthreads; t++)
+        free(eq->listas[t].arestas);
+    pthread_cond_destroy(&eq->acordar);
+    pthread_mutex_destroy(&eq->lock);
+    free(eq->listas);
+    free(eq->membros);
+}
+
+static void relaxar_hub_em_equipe(DijkstraWorkspace *ws, int u, int du, const Edge *e, int grau)
+{
+    EquipeHubs *eq = ws->equipe;
+    eq->ws = ws;
+    eq->e = e;
+    eq->du = du;
+    eq->grau = grau;
+    __atomic_store_n(&eq->restantes, eq->nthreads - 1, __ATOMIC_RELAXED);
+    publicar_geracao(eq);
+    varrer_fatia(eq, 0);
+    int giro = 0;
+    while (__atomic_load_n(&eq->restantes, __ATOMIC_ACQUIRE) > 0)
+        espera_curta(giro++);
+    for (int t = 0; t < eq->nthreads; t++)
+    {
+        ListaMelhorias *l = &eq->listas[t];
+        for (int k = 0; k < l->tamanho; k++)
+            dijkstra_workspace_relax(ws, u, e[l->arestas[k]].dest, du + e[l->arestas[k]].weight);
+        l->tamanho = 0;
+    }
+    eq->divididos++;
+}
+
+// Assenta o próximo vértice e relaxa suas arestas; -1 quando o heap esvazia
+int dijkstra_workspace_next(DijkstraWorkspace *ws, Graph *g)
+{
+    if (ws->heap.size == 0)
+        return -1;
+    int u = extract_min(&ws->heap);
+    int du = ws->state[u].dist;
+    ws->state[u].pos = SETTLED;
+    const Edge *e = g->vertices[u].edges;
+    int grau = g->vertices[u].edge_count, i = 0;
+    if (ws->equipe && grau >= ws->equipe->limiar)
+    {
+        relaxar_hub_em_equipe(ws, u, du, e, grau);
+        return u;
+    }
+    if (grau >= LISTA_LONGA)
+        i = relaxar_lista_vetorial(ws, u, du, e, grau);
+    for (; i < grau; i++)
+    {
+        if (i + DISTANCIA_PREFETCH < grau)
+            __builtin_prefetch(&ws->state[e[i + DISTANCIA_PREFETCH].dest]);
+        dijkstra_workspace_relax(ws, u, e[i].dest, du + e[i].weight);
+    }
+    return u;
+}
+
+// Dijkstra completo a partir de start sobre a área de trabalho; as distâncias
+// ficam em workspace_dist() e os caminhos em workspace_path(). Retorna o número
+// de vértices alcançados.
+int dijkstra_workspace(DijkstraWorkspace *ws, Graph *g, int start)
+{
+    int alcancados = 0;
+    dijkstra_workspace_reset(ws);
+    dijkstra_workspace_seed(ws, start, 0);
+    while (dijkstra_workspace_next(ws, g) >= 0)
+        alcancados++;
+    return alcancados;
+}
+
+// Grafo reverso: rev contém v->u para cada aresta u->v de g
+void build_reverse_graph(Graph *g, Graph *rev)
+{
+    init_graph(rev, g->n);
+    rev->directed = g->directed;
+    for (int u = 0; u < g->n; u++)
+        for (int i = 0; i < g->vertices[u].edge_count; i++)
+            add_edge(rev, g->vertices[u].edges[i].dest, u, g->vertices[u].edges[i].weight);
+    compactar_arestas(rev);
+}
+
+#define EDGE_DELETED -1
+
+typedef struct
+{
+    int u;
+    int v;
+    int weight; // novo peso, ou EDGE_DELETED para remover o arco
+} EdgeUpdate;
+
+// SSSP dinâmico: mantém dist/pred da última consulta e os repara localmente
+// a cada lote de atualizações, em vez de rodar dijkstra() do zero
+typedef struct
+{
+    Graph *g;
+    Graph *rev; // arestas de entrada (o próprio g se não for direcionado)
+    int source;
+    VertexState *state; // dist, pred e posição no heap (-1 se fora dele)
+    int *first_child; // filhos na árvore de caminhos mínimos (lista dupla)
+    int *next_sibling;
+    int *prev_sibling;
+    MinHeap heap;
+    char *invalid;
+    int *affected;
+} DynamicSSSP;
+
+// Troca o pai de v na árvore mantendo as listas de filhos em O(1)
+static void set_parent(DynamicSSSP *d, int v, int parent)
+{
+    int antigo = d->state[v].pred;
+    if (antigo == parent)
+        return;
+    if (antigo >= 0)
+    {
+        if (d->prev_sibling[v] >= 0)
+            d->next_sibling[d->prev_sibling[v]] = d->next_sibling[v];
+        else
+            d->first_child[antigo] = d->next_sibling[v];
+        if (d->next_sibling[v] >= 0)
+            d->prev_sibling[d->next_sibling[v]] = d->prev_sibling[v];
+    }
+    d->state[v].pred = parent;
+    d->prev_sibling[v] = -1;
+    d->next_sibling[v] = -1;
+    if (parent >= 0)
+    {
+        d->next_sibling[v] = d->first_child[parent];
+        if (d->first_child[parent] >= 0)
+            d->prev_sibling[d->first_child[parent]] = v;
+        d->first_child[parent] = v;
+    }
+}
+
+void dynamic_sssp_init(DynamicSSSP *d, Graph *g, int source)
+{
+    int n = g->n;
+    d->g = g;
+    d->source = source;
+    if (g->directed)
+    {
+        d->rev = malloc(sizeof(Graph));
+        build_reverse_graph(g, d->rev);
+    }
+    else
+        d->rev = g;
+    int *pred = malloc(n * sizeof(int));
+    int *dist = dijkstra_pred(g, source, pred);
+    d->state = malloc(n * sizeof(VertexState));
+    d->first_child = malloc(n * sizeof(int));
+    d->next_sibling = malloc(n * sizeof(int));
+    d->prev_sibling = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++)
+    {
+        d->state[i] = (VertexState){dist[i], -1, 0, -1};
+        d->first_child[i] = -1;
+    }
+    for (int i = 0; i < n; i++)
+        set_parent(d, i, pred[i]);
+    free(pred);
+    free(dist);
+    d->heap.nodes = malloc(n * sizeof(int));
+    d->heap.state = d->state;
+    d->heap.size = 0;
+    d->invalid = calloc(n, sizeof(char));
+    d->affected = malloc(n * sizeof(int));
+}
+
+void dynamic_sssp_free(DynamicSSSP *d)
+{
+    if (d->rev != d->g)
+    {
+        free_graph(d->rev);
+        free(d->rev);
+    }
+    free(d->state);
+    free(d->first_child);
+    free(d->next_sibling);
+    free(d->prev_sibling);
+    free(d->heap.nodes);
+    free(d->invalid);
+    free(d->affected);
+}
+
+// Aplica u->v com peso w no grafo: insere o arco ou reduz o peso do arco
+// existente. Retorna 1 se o grafo mudou.
+static int aplicar_reducao(Graph *g, int u, int v, int w)
+{
+    AdjList *list = &g->vertices[u];
+    Edge *existente = NULL;
+    for (int i = 0; i < list->edge_count; i++)
+        if (list->edges[i].dest == v && (!existente || list->edges[i].weight < existente->weight))
+            existente = &list->edges[i];
+    if (!existente)
+    {
+        add_edge(g, u, v, w);
+        return 1;
+    }
+    if (w >= existente->weight)
+        return 0;
+    existente->weight = w;
+    if (w < g->min_weight)
+        g->min_weight = w;
+    return 1;
+}
+
+static void dynamic_sssp_seed(DynamicSSSP *d, int u, int v, int w)
+{
+    int du = d->state[u].dist;
+    VertexState *sv = &d->state[v];
+    if (du == INF || du + w >= sv->dist)
+        return;
+    sv->dist = du + w;
+    set_parent(d, v, u);
+    if (sv->pos < 0)
+        heap_insert(&d->heap, v);
+    else
+        decrease_key(&d->heap, v, sv->dist);
+}
+
+// Dijkstra restrito à região afetada: só entram no heap vértices cuja
+// distância diminuiu. Retorna quantos vértices foram assentados.
+static int dynamic_sssp_propagate(DynamicSSSP *d)
+{
+    int alterados = 0;
+    while (d->heap.size > 0)
+    {
+        int u = extract_min(&d->heap);
+        d->state[u].pos = -1;
+        alterados++;
+        AdjList *list = &d->g->vertices[u];
+        for (int i = 0; i < list->edge_count; i++)
+            dynamic_sssp_seed(d, u, list->edges[i].dest, list->edges[i].weight);
+    }
+    return alterados;
+}
+
+// Lote de inserções de arestas e reduções de peso (nos dois sentidos se o
+// grafo não for direcionado). O custo é proporcional aos vértices cuja
+// distância muda. Retorna o número desses vértices.
+int dynamic_sssp_insert(DynamicSSSP *d, const EdgeUpdate *updates, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const EdgeUpdate *e = &updates[i];
+        if (aplicar_reducao(d->g, e->u, e->v, e->weight))
+        {
+            if (d->rev != d->g)
+                aplicar_reducao(d->rev, e->v, e->u, e->weight);
+            dynamic_sssp_seed(d, e->u, e->v, e->weight);
+        }
+        if (!d->g->directed && aplicar_reducao(d->g, e->v, e->u, e->weight))
+            dynamic_sssp_seed(d, e->v, e->u, e->weight);
+    }
+    return dynamic_sssp_propagate(d);
+}
+
+// Aplica u->v com peso w (ou remoção) no arco u->v mais barato. Retorna 1 se
+// o grafo mudou.
+static int aplicar_aumento(Graph *g, int u, int v, int w)
+{
+    AdjList *list = &g->vertices[u];
+    int k = -1;
+    for (int i = 0; i < list->edge_count; i++)
+        if (list->edges[i].dest == v && (k < 0 || list->edges[i].weight < list->edges[k].weight))
+            k = i;
+    if (k < 0)
+        return 0;
+    if (w == EDGE_DELETED)
+    {
+        list->edges[k] = list->edges[--list->edge_count];
+        g->m--;
+        return 1;
+    }
+    if (w <= list->edges[k].weight)
+        return 0;
+    list->edges[k].weight = w;
+    if (w > g->max_weight)
+        g->max_weight = w;
+    return 1;
+}
+
+// Menor peso entre os arcos u->v restantes (INF se não houver)
+static int peso_arco(Graph *g, int u, int v)
+{
+    int melhor = INF;
+    AdjList *list = &g->vertices[u];
+    for (int i = 0; i < list->edge_count; i++)
+        if (list->edges[i].dest == v && list->edges[i].weight < melhor)
+            melhor = list->edges[i].weight;
+    return melhor;
+}
+
+// Se u->v era aresta da árvore e piorou, invalida a subárvore de v
+static int invalidar_subarvore(DynamicSSSP *d, int u, int v, int count)
+{
+    if (d->state[v].pred != u || d->invalid[v])
+        return count;
+    int w = peso_arco(d->g, u, v);
+    if (w != INF && d->state[u].dist != INF && d->state[u].dist + w == d->state[v].dist)
+        return count;
+    // Percorre a subárvore pelas listas de filhos, usando affected como fila
+    int inicio = count;
+    d->invalid[v] = 1;
+    d->affected[count++] = v;
+    while (inicio < count)
+    {
+        int x = d->affected[inicio++];
+        for (int c = d->first_child[x]; c >= 0; c = d->next_sibling[c])
+        {
+            if (!d->invalid[c])
+            {
+                d->invalid[c] = 1;
+                d->affected[count++] = c;
+            }
+        }
+    }
+    return count;
+}
+
+// Lote de remoções de arestas e aumentos de peso, no estilo de Ramalingam &
+// Reps: invalida as subárvores cuja aresta para o pai piorou e as recalcula a
+// partir da fronteira ainda válida. Retorna o número de vértices invalidados.
+int dynamic_sssp_increase(DynamicSSSP *d, const EdgeUpdate *updates, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const EdgeUpdate *e = &updates[i];
+        if (aplicar_aumento(d->g, e->u, e->v, e->weight) && d->rev != d->g)
+            aplicar_aumento(d->rev, e->v, e->u, e->weight);
+        if (!d->g->directed)
+            aplicar_aumento(d->g, e->v, e->u, e->weight);
+    }
+
+    int afetados = 0;
+    for (int i = 0; i < count; i++)
+    {
+        afetados = invalidar_subarvore(d, updates[i].u, updates[i].v, afetados);
+        if (!d->g->directed)
+            afetados = invalidar_subarvore(d, updates[i].v, updates[i].u, afetados);
+    }
+
+    for (int i = 0; i < afetados; i++)
+    {
+        int x = d->affected[i];
+        set_parent(d, x, -1);
+        d->state[x].dist = INF;
+    }
+    // Melhor distância de cada vértice invalidado vinda da fronteira válida
+    for (int i = 0; i < afetados; i++)
+    {
+        int x = d->affected[i];
+        AdjList *entrada = &d->rev->vertices[x];
+        for (int k = 0; k < entrada->edge_count; k++)
+        {
+            int y = entrada->edges[k].dest;
+            if (!d->invalid[y])
+                dynamic_sssp_seed(d, y, x, entrada->edges[k].weight);
+        }
+    }
+    for (int i = 0; i < afetados; i++)
+        d->invalid[d->affected[i]] = 0;
+    dynamic_sssp_propagate(d);
+    return afetados;
+}
+
+static int escrever_varint(unsigned char *out, unsigned int x)
+{
+    int k = 0;
+    while (x >= 0x80)
+    {
+        out[k++] = (unsigned char)(x | 0x80);
+        x >>= 7;
+    }
+    out[k++] = (unsigned char)x;
+    return k;
+}
+
+static const unsigned char *ler_varint(const unsigned char *p, const unsigned char *end, unsigned int *x)
+{
+    unsigned int valor = 0;
+    int shift = 0;
+    while (p < end && shift < 35)
+    {
+        unsigned char b = *p++;
+        valor |= (unsigned int)(b & 0x7f) << shift;
+        if (!(b & 0x80))
+        {
+            *x = valor;
+            return p;
+        }
+        shift += 7;
+    }
+    return NULL;
+}
+
+#define ARVORE_MAGIC "SPT1"
+
+// Exporta a árvore de caminhos mínimos em formato binário compacto:
+// cabeçalho "SPT1", n e start (int32), seguido, para cada vértice, de dois
+// varints: (pred[v] - v) em zigzag (0 = sem antecessor) e o peso da aresta
+// da árvore, dist[v] - dist[pred[v]]. Retorna o número de bytes escritos.
+long salvar_arvore_binaria(const char *filename, const int *pred, const int *dist, int n, int start)
+{
+    FILE *f = fopen(filename, "wb");
+    if (!f)
+        return -1;
+    int cabecalho[2] = {n, start};
+    fwrite(ARVORE_MAGIC, 1, 4, f);
+    fwrite(cabecalho, sizeof(int), 2, f);
+    long total = 4 + sizeof(cabecalho);
+
+    unsigned char bloco[4096 + 10];
+    int usado = 0;
+    for (int v = 0; v < n; v++)
+    {
+        unsigned int delta = 0, peso = 0;
+        if (pred[v] >= 0)
+        {
+            int d = pred[v] - v;
+            delta = ((unsigned int)d << 1) ^ (unsigned int)(d >> 31);
+            peso = (unsigned int)(dist[v] - dist[pred[v]]);
+        }
+        usado += escrever_varint(bloco + usado, delta);
+        usado += escrever_varint(bloco + usado, peso);
+        if (usado >= 4096)
+        {
+            fwrite(bloco, 1, usado, f);
+            total += usado;
+            usado = 0;
+        }
+    }
+    fwrite(bloco, 1, usado, f);
+    total += usado;
+    fclose(f);
+    return total;
+}
+
+// Lê uma árvore salva por salvar_arvore_binaria, alocando pred e dist
+int carregar_arvore_binaria(const char *filename, int **pred_out, int **dist_out, int *n_out, int *start_out)
+{
+    FILE *f = fopen(filename, "rb");
+    if (!f)
+        return 0;
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    rewind(f);
+    char *buffer = malloc(len > 0 ? len : 1);
+    if (!buffer || fread(buffer, 1, len, f) != (size_t)len)
+    {
+        free(buffer);
+        fclose(f);
+        return 0;
+    }
+    fclose(f);
+
+    int cabecalho[2];
+    if (len < 4 + (long)sizeof(cabecalho) || memcmp(buffer, ARVORE_MAGIC, 4) != 0)
+    {
+        free(buffer);
+        return 0;
+    }
+    memcpy(cabecalho, buffer + 4, sizeof(cabecalho));
+    int n = cabecalho[0], start = cabecalho[1];
+    const unsigned char *p = (const unsigned char *)buffer + 4 + sizeof(cabecalho);
+    const unsigned char *end = (const unsigned char *)buffer + len;
+    // Cada vértice ocupa ao menos dois bytes (delta e peso)
+    if (n <= 0 || n > (end - p) / 2 || start < 0 || start >= n)
+    {
+        free(buffer);
+        return 0;
+    }
+    int *pred = malloc(n * sizeof(int));
+    int *peso = malloc(n * sizeof(int));
+    int *dist = malloc(n * sizeof(int));
+    int *pilha = malloc(n * sizeof(int));
+    int ok = pred && peso && dist && pilha;
+    for (int v = 0; ok && v < n; v++)
+    {
+        unsigned int delta, w;
+        if (!(p = ler_varint(p, end, &delta)) || !(p = ler_varint(p, end, &w)))
+        {
+            ok = 0;
+            break;
+        }
+        long long u = delta ? v + (long long)(int)((delta >> 1) ^ -(delta & 1)) : -1;
+        if (u < -1 || u >= n)
+            ok = 0;
+        pred[v] = (int)u;
+        peso[v] = (int)w;
+        dist[v] = -1;
+    }
+    free(buffer);
+
+    // Distâncias: sobe até um ancestral já resolvido e desce acumulando os
+    // pesos; uma subida com mais de n vértices só pode ser um ciclo
+    for (int v = 0; ok && v < n; v++)
+    {
+        int topo = 0, u = v;
+        while (dist[u] < 0 && pred[u] >= 0)
+        {
+            if (topo == n)
+            {
+                ok = 0;
+                break;
+            }
+            pilha[topo++] = u;
+            u = pred[u];
+        }
+        if (!ok)
+            break;
+        if (dist[u] < 0)
+            dist[u] = u == start ? 0 : INF;
+        while (topo > 0)
+        {
+            int x = pilha[--topo];
+            dist[x] = dist[pred[x]] == INF ? INF : dist[pred[x]] + peso[x];
+        }
+    }
+    if (!ok)
+    {
+        free(pred);
+        free(peso);
+        free(dist);
+        free(pilha);
+        return 0;
+    }
+    free(pilha);
+    free(peso);
+
+    *pred_out = pred;
+    *dist_out = dist;
+    *n_out = n;
+    *start_out = start;
+    return 1;
+}
+
+// Relê a árvore salva em filename e confere com a busca que a gerou: pred e
+// dist idênticos e, para alguns destinos, o caminho de extract_path somando
+// exatamente dist[t] com os pesos das arestas do grafo
+int conferir_arvore_salva(Graph *g, const char *filename, const int *pred, const int *dist, int start)
+{
+    int *pred_lido, *dist_lido, n, start_lido;
+    if (!carregar_arvore_binaria(filename, &pred_lido, &dist_lido, &n, &start_lido))
+        return 0;
+    int ok = n == g->n && start_lido == start;
+    for (int v = 0; ok && v < n; v++)
+        ok = pred_lido[v] == pred[v] && dist_lido[v] == dist[v];
+
+    int *caminho = malloc(n * sizeof(int));
+    int destinos[] = {n - 1, n / 2, n / 3, n / 4, start};
+    for (int i = 0; ok && i < (int)(sizeof(destinos) / sizeof(destinos[0])); i++)
+    {
+        int t = destinos[i];
+        int len = extract_path(pred_lido, start, t, caminho, n);
+        if (len == 0)
+        {
+            ok = dist[t] == INF;
+            continue;
+        }
+        long long soma = 0;
+        for (int k = 1; k < len; k++)
+            soma += peso_arco(g, caminho[k - 1], caminho[k]);
+        ok = caminho[0] == start && caminho[len - 1] == t && soma == dist[t];
+    }
+    free(caminho);
+    free(pred_lido);
+    free(dist_lido);
+    return ok;
+}
+
+typedef struct
+{
+    int vertex;
+    int dist;
+} Neighbor;
+
+// Busca curta sobre a área de trabalho: o custo fica proporcional aos
+// vértices tocados, não a n
+typedef struct
+{
+    DijkstraWorkspace ws;
+    Neighbor *result; // vértices assentados, em ordem crescente de distância
+    int result_count;
+    int result_capacity;
+    // Máscara preguiçosa (usada pelo Yen): vértices com blocked[v] ==
+    // block_epoch e arcos spur->blocked_dest[i] ficam fora da busca
+    int masking;
+    unsigned int *blocked;
+    unsigned int block_epoch;
+    int spur;
+    int *blocked_dest;
+    int blocked_count;
+    int blocked_capacity;
+} SparseSearch;
+
+void sparse_search_init(SparseSearch *ss, int n)
+{
+    dijkstra_workspace_init(&ss->ws, n);
+    ss->result = NULL;
+    ss->result_count = 0;
+    ss->result_capacity = 0;
+    ss->masking = 0;
+    ss->blocked = NULL;
+    ss->block_epoch = 0;
+    ss->spur = -1;
+    ss->blocked_dest = NULL;
+    ss->blocked_count = 0;
+    ss->blocked_capacity = 0;
+}
+
+void sparse_search_free(SparseSearch *ss)
+{
+    dijkstra_workspace_free(&ss->ws);
+    free(ss->result);
+    free(ss->blocked);
+    free(ss->blocked_dest);
+}
+
+void sparse_search_start(SparseSearch *ss, int source)
+{
+    dijkstra_workspace_reset(&ss->ws);
+    dijkstra_workspace_seed(&ss->ws, source, 0);
+    ss->result_count = 0;
+}
+
+// Nova máscara vazia: bloqueios anteriores deixam de valer sem limpar nada
+static void sparse_search_mask_reset(SparseSearch *ss, int spur)
+{
+    if (!ss->blocked)
+        ss->blocked = calloc(ss->ws.n, sizeof(unsigned int));
+    if (++ss->block_epoch == 0)
+    {
+        memset(ss->blocked, 0, ss->ws.n * sizeof(unsigned int));
+        ss->block_epoch = 1;
+    }
+    ss->spur = spur;
+    ss->blocked_count = 0;
+    ss->masking = 1;
+}
+
+static void sparse_search_block_edge(SparseSearch *ss, int v)
+{
+    if (ss->blocked_count == ss->blocked_capacity)
+    {
+        ss->blocked_capacity = ss->blocked_capacity ? ss->blocked_capacity * 2 : 8;
+        ss->blocked_dest = realloc(ss->blocked_dest, ss->blocked_capacity * sizeof(int));
+    }
+    ss->blocked_dest[ss->blocked_count++] = v;
+}
+
+static int sparse_search_masked(SparseSearch *ss, int u, int v)
+{
+    if (ss->blocked[v] == ss->block_epoch)
+        return 1;
+    if (u == ss->spur)
+        for (int i = 0; i < ss->blocked_count; i++)
+            if (ss->blocked_dest[i] == v)
+                return 1;
+    return 0;
+}
+
+// Assenta o próximo vértice (a distância fica em ss->ws.state) e relaxa suas
+// arestas, ignorando caminhos maiores que radius. Retorna -1 ao esgotar.
+int sparse_search_next(SparseSearch *ss, Graph *g, int radius)
+{
+    DijkstraWorkspace *ws = &ss->ws;
+    if (ws->heap.size == 0)
+        return -1;
+    int u = extract_min(&ws->heap);
+    int du = ws->state[u].dist;
+    ws->state[u].pos = SETTLED;
+
+    for (int i = 0; i < g->vertices[u].edge_count; i++)
+    {
+        int v = g->vertices[u].edges[i].dest;
+        int nd = du + g->vertices[u].edges[i].weight;
+        if (nd > radius || (ss->masking && sparse_search_masked(ss, u, v)))
+            continue;
+        dijkstra_workspace_relax(ws, u, v, nd);
+    }
+    return u;
+}
+
+// Dijkstra que para ao ultrapassar radius ou ao assentar k vértices
+static int bounded_search(SparseSearch *ss, Graph *g, int source, int radius, int k)
+{
+    sparse_search_start(ss, source);
+    int u;
+    while (ss->result_count < k && (u = sparse_search_next(ss, g, radius)) >= 0)
+    {
+        if (ss->result_count == ss->result_capacity)
+        {
+            ss->result_capacity = ss->result_capacity ? ss->result_capacity * 2 : 64;
+            ss->result = realloc(ss->result, ss->result_capacity * sizeof(Neighbor));
+        }
+        ss->result[ss->result_count++] = (Neighbor){u, ss->ws.state[u].dist};
+    }
+    return ss->result_count;
+}
+
+// Todos os vértices a distância <= radius de source (em ss->result)
+int radius_search(SparseSearch *ss, Graph *g, int source, int radius)
+{
+    return bounded_search(ss, g, source, radius, INT_MAX);
+}
+
+// Os k vértices mais próximos de source, incluindo o próprio source
+int knn_search(SparseSearch *ss, Graph *g, int source, int k)
+{
+    return bounded_search(ss, g, source, INF, k);
+}
+
+typedef struct
+{
+    int target; // posição na lista de destinos
+    int dist;   // distância do vértice do balde até o destino
+} BucketEntry;
+
+// Menor distância com que a busca direta ainda pode achar algo novo: se a
+// busca reversa de t assentou todo vértice com d(v, t) <= raio, um caminho
+// mínimo s->t entra nessa bola por um x com d(s, x) < best - raio + W
+static long long limite_busca_direta(const int *best, const int *raio, int nt, int peso_max)
+{
+    long long limite = 1;
+    for (int j = 0; j < nt; j++)
+    {
+        if (raio[j] == INF)
+            continue; // bola completa: o próprio s está no balde, se alcançar t
+        if (best[j] == INF)
+            return LLONG_MAX;
+        long long termo = (long long)best[j] - raio[j] + peso_max;
+        if (termo > limite)
+            limite = termo;
+    }
+    return limite;
+}
+
+// Tabela |S|x|T| de distâncias para origens e destinos de um mesmo
+// componente (com size vértices): uma busca reversa limitada a partir de cada
+// destino deixa (destino, distância) nos baldes dos vértices que assentou e
+// uma busca direta a partir de cada origem varre esses baldes, parando assim
+// que nenhum destino pode melhorar. Os baldes são indexados pela posição do
+// vértice no componente. Retorna o total de vértices assentados.
+static long long many_to_many_core(Graph *g, Graph *rev, SparseSearch *ss, int size, const int *sources, int ns, const int *targets, int nt, int *table)
+{
+    const int *local = g->local_index;
+    long long settled = 0;
+
+    // Bolas de size/sqrt(|T|) vértices equilibram o trabalho das buscas
+    // reversas (sqrt(|T|)·size no total) com o quanto as diretas param cedo
+    int orcamento = (int)(size / sqrt(nt));
+    if (orcamento < 64)
+        orcamento = 64;
+    if (orcamento > size)
+        orcamento = size;
+
+    // Buscas reversas: (vértice, destino, distância) em ordem de destino
+    int *raio = malloc(nt * sizeof(int));
+    int *bucket_start = calloc(size + 1, sizeof(int));
+    int *entrada_vertice = malloc((size_t)nt * orcamento * sizeof(int));
+    BucketEntry *entradas = malloc((size_t)nt * orcamento * sizeof(BucketEntry));
+    int total = 0;
+    for (int j = 0; j < nt; j++)
+    {
+        int c = knn_search(ss, rev, targets[j], orcamento);
+        settled += c;
+        raio[j] = c < orcamento ? INF : ss->result[c - 1].dist - 1;
+        for (int i = 0; i < c; i++)
+        {
+            int v = ss->result[i].vertex;
+            entrada_vertice[total] = local ? local[v] : v;
+            entradas[total++] = (BucketEntry){j, ss->result[i].dist};
+            bucket_start[(local ? local[v] : v) + 1]++;
+        }
+    }
+    for (int v = 0; v < size; v++)
+        bucket_start[v + 1] += bucket_start[v];
+    BucketEntry *buckets = malloc((total > 0 ? total : 1) * sizeof(BucketEntry));
+    int *cursor = malloc(size * sizeof(int));
+    memcpy(cursor, bucket_start, size * sizeof(int));
+    for (int i = 0; i < total; i++)
+        buckets[cursor[entrada_vertice[i]]++] = entradas[i];
+    free(cursor);
+    free(entradas);
+    free(entrada_vertice);
+
+    // Buscas diretas
+    for (long long i = 0; i < (long long)ns * nt; i++)
+        table[i] = INF;
+    for (int i = 0; i < ns; i++)
+    {
+        int *best = table + (size_t)i * nt;
+        long long limite = LLONG_MAX;
+        int mudou = 1;
+        int u;
+        sparse_search_start(ss, sources[i]);
+        while ((u = sparse_search_next(ss, g, INF)) >= 0)
+        {
+            settled++;
+            int du = ss->ws.state[u].dist;
+            if (mudou)
+            {
+                limite = limite_busca_direta(best, raio, nt, g->max_weight);
+                mudou = 0;
+            }
+            if (du >= limite)
+                break;
+            int lu = local ? local[u] : u;
+            for (int k = bucket_start[lu]; k < bucket_start[lu + 1]; k++)
+            {
+                int d = du + buckets[k].dist;
+                if (d < best[buckets[k].target])
+                {
+                    best[buckets[k].target] = d;
+                    mudou = 1;
+                }
+            }
+        }
+    }
+
+    free(buckets);
+    free(bucket_start);
+    free(raio);
+    return settled;
+}
+
+// Grupo de origens/destinos de um componente, resolvido de forma independente
+typedef struct
+{
+    int component;
+    int *source_idx; // posições em sources
+    int ns;
+    int *target_idx; // posições em targets
+    int nt;
+} ComponentTask;
+
+typedef struct
+{
+    Graph *g;
+    Graph *rev;
+    const int *sources;
+    const int *targets;
+    int nt_total;
+    int *table;
+    ComponentTask *tasks;
+    int num_tasks;
+    int next_task;
+    long long settled;
+} ManyToManyJob;
+
+static void *many_to_many_worker(void *arg)
+{
+    ManyToManyJob *job = arg;
+    SparseSearch ss;
+    sparse_search_init(&ss, job->g->n);
+    int t;
+    while ((t = __atomic_fetch_add(&job->next_task, 1, __ATOMIC_RELAXED)) < job->num_tasks)
+    {
+        ComponentTask *task = &job->tasks[t];
+        int *origens = malloc(task->ns * sizeof(int));
+        int *destinos = malloc(task->nt * sizeof(int));
+        int *parcial = malloc((size_t)task->ns * task->nt * sizeof(int));
+        for (int i = 0; i < task->ns; i++)
+            origens[i] = job->sources[task->source_idx[i]];
+        for (int j = 0; j < task->nt; j++)
+            destinos[j] = job->targets[task->target_idx[j]];
+        int size = job->g->component ? job->g->component_start[task->component + 1] - job->g->component_start[task->component] : job->g->n;
+        long long settled = many_to_many_core(job->g, job->rev, &ss, size, origens, task->ns, destinos, task->nt, parcial);
+        __atomic_fetch_add(&job->settled, settled, __ATOMIC_RELAXED);
+        for (int i = 0; i < task->ns; i++)
+            for (int j = 0; j < task->nt; j++)
+                job->table[(size_t)task->source_idx[i] * job->nt_total + task->target_idx[j]] = parcial[(size_t)i * task->nt + j];
+        free(parcial);
+        free(origens);
+        free(destinos);
+    }
+    sparse_search_free(&ss);
+    return NULL;
+}
+
+// Tabela |S|x|T| de distâncias, com table[i * nt + j] = dist(sources[i], targets[j]).
+// Pares em componentes diferentes ficam em INF sem busca alguma; cada
+// componente com origens e destinos vira uma tarefa independente, distribuída
+// entre threads. Se settled_out não for NULL, recebe o total de vértices assentados.
+int *many_to_many(Graph *g, const int *sources, int ns, const int *targets, int nt, long long *settled_out)
+{
+    Graph rev_local;
+    Graph *rev = g;
+    if (g->directed)
+    {
+        build_reverse_graph(g, &rev_local);
+        rev = &rev_local;
+    }
+    int *table = malloc((size_t)ns * nt * sizeof(int));
+    for (long long i = 0; i < (long long)ns * nt; i++)
+        table[i] = INF;
+
+    // Agrupa origens e destinos por componente
+    int nc = g->component ? g->num_components : 1;
+    ComponentTask *por_componente = calloc(nc, sizeof(ComponentTask));
+    for (int i = 0; i < ns; i++)
+        por_componente[g->component ? g->component[sources[i]] : 0].ns++;
+    for (int j = 0; j < nt; j++)
+        por_componente[g->component ? g->component[targets[j]] : 0].nt++;
+    int num_tasks = 0;
+    for (int c = 0; c < nc; c++)
+        if (por_componente[c].ns > 0 && por_componente[c].nt > 0)
+            num_tasks++;
+    ComponentTask *tasks = calloc(num_tasks > 0 ? num_tasks : 1, sizeof(ComponentTask));
+    int *tarefa_do_componente = malloc(nc * sizeof(int));
+    num_tasks = 0;
+    for (int c = 0; c < nc; c++)
+    {
+        tarefa_do_componente[c] = -1;
+        if (por_componente[c].ns > 0 && por_componente[c].nt > 0)
+        {
+            ComponentTask *task = &tasks[num_tasks];
+            task->component = c;
+            task->source_idx = malloc(por_componente[c].ns * sizeof(int));
+            task->target_idx = malloc(por_componente[c].nt * sizeof(int));
+            tarefa_do_componente[c] = num_tasks++;
+        }
+    }
+    for (int i = 0; i < ns; i++)
+    {
+        int t = tarefa_do_componente[g->component ? g->component[sources[i]] : 0];
+        if (t >= 0)
+            tasks[t].source_idx[tasks[t].ns++] = i;
+    }
+    for (int j = 0; j < nt; j++)
+    {
+        int t = tarefa_do_componente[g->component ? g->component[targets[j]] : 0];
+        if (t >= 0)
+            tasks[t].target_idx[tasks[t].nt++] = j;
+    }
+    free(tarefa_do_componente);
+    free(por_componente);
+
+    ManyToManyJob job = {g, rev, sources, targets, nt, table, tasks, num_tasks, 0, 0};
+    int nthreads = numero_de_threads();
+    if (nthreads > num_tasks)
+        nthreads = num_tasks;
+    pthread_t *threads = malloc((nthreads > 0 ? nthreads : 1) * sizeof(pthread_t));
+    for (int t = 1; t < nthreads; t++)
+        pthread_create(&threads[t], NULL, many_to_many_worker, &job);
+    if (num_tasks > 0)
+        many_to_many_worker(&job);
+    for (int t = 1; t < nthreads; t++)
+        pthread_join(threads[t], NULL);
+    free(threads);
+
+    for (int t = 0; t < num_tasks; t++)
+    {
+        free(tasks[t].source_idx);
+        free(tasks[t].target_idx);
+    }
+    free(tasks);
+    if (rev != g)
+        free_graph(rev);
+    if (settled_out)
+        *settled_out = job.settled;
+    return table;
+}
+
+// Distância de s a t com parada antecipada; s e t em componentes diferentes
+// retornam INF sem busca
+int shortest_distance(SparseSearch *ss, Graph *g, int s, int t)
+{
+    if (!same_component(g, s, t))
+        return INF;
+    int u;
+    sparse_search_start(ss, s);
+    while ((u = sparse_search_next(ss, g, INF)) >= 0)
+        if (u == t)
+            return ss->ws.state[t].dist;
+    return INF;
+}
+
+// Dijkstra multi-origem em faixas: cada vértice guarda um vetor de L
+// distâncias, uma por origem, e as L buscas avançam juntas lendo as arestas
+// uma única vez por grupo. Como as faixas não assentam na mesma ordem, o
+// escalonamento é de correção de rótulos: um vértice volta ao heap sempre
+// que alguma faixa melhora, com a menor distância melhorada como chave.
+#define FAIXAS_MAX 16
+#define DIST_FAIXA_INF 0x3fffffff // infinito interno: soma com peso não transborda
+
+// Relaxa dv = min(dv, du + w) nas L faixas; retorna a menor distância
+// melhorada, ou INF se nenhuma faixa melhorou
+typedef int (*RelaxarFaixas)(int *dv, const int *du, int w);
+
+static int relaxar_faixas_escalar(int *dv, const int *du, int w, int faixas)
+{
+    int menor = INF;
+    for (int j = 0; j < faixas; j++)
+    {
+        int c = du[j] + w;
+        if (c < dv[j])
+        {
+            dv[j] = c;
+            if (c < menor)
+                menor = c;
+        }
+    }
+    return menor;
+}
+
+static int relaxar_8_escalar(int *dv, const int *du, int w)
+{
+    return relaxar_faixas_escalar(dv, du, w, 8);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static int menor_faixa_avx2(__m256i c, __m256i melhorou)
+{
+    __m256i x = _mm256_blendv_epi8(_mm256_set1_epi32(INF), c, melhorou);
+    x = _mm256_min_epi32(x, _mm256_permute2x128_si256(x, x, 1));
+    x = _mm256_min_epi32(x, _mm256_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+    x = _mm256_min_epi32(x, _mm256_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm256_cvtsi256_si32(x);
+}
+
+__attribute__((target("avx2"))) static int relaxar_8_avx2(int *dv, const int *du, int w)
+{
+    __m256i c = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)du), _mm256_set1_epi32(w));
+    __m256i d = _mm256_loadu_si256((const __m256i *)dv);
+    __m256i melhorou = _mm256_cmpgt_epi32(d, c);
+    if (_mm256_testz_si256(melhorou, melhorou))
+        return INF;
+    _mm256_storeu_si256((__m256i *)dv, _mm256_min_epi32(c, d));
+    return menor_faixa_avx2(c, melhorou);
+}
+
+__attribute__((target("avx512f"))) static int relaxar_16_avx512(int *dv, const int *du, int w)
+{
+    __m512i c = _mm512_add_epi32(_mm512_loadu_si512(du), _mm512_set1_epi32(w));
+    __m512i d = _mm512_loadu_si512(dv);
+    __mmask16 melhorou = _mm512_cmpgt_epi32_mask(d, c);
+    if (!melhorou)
+        return INF;
+    _mm512_mask_storeu_epi32(dv, melhorou, c);
+    return _mm512_mask_reduce_min_epi32(melhorou, c);
+}
+#endif
+
+// Largura e núcleo de relaxação conforme o processador: 16 faixas com
+// AVX-512, 8 com AVX2, 8 em C puro nos demais
+int escolher_faixas(RelaxarFaixas *relaxar, const char **nome)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        *relaxar = relaxar_16_avx512;
+        *nome = "AVX-512";
+        return 16;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        *relaxar = relaxar_8_avx2;
+        *nome = "AVX2";
+        return 8;
+    }
+#endif
+    *relaxar = relaxar_8_escalar;
+    *nome = "escalar";
+    return 8;
+}
+
+// Um grupo de até L origens; as faixas sem origem ficam em infinito e nunca
+// melhoram
+static void multi_source_group(Graph *g, const int *sources, int k, int faixas, RelaxarFaixas relaxar,
+                               int *dist, VertexState *st, MinHeap *heap, int *tabela, int linha0)
+{
+    int n = g->n;
+    for (long long i = 0; i < (long long)n * faixas; i++)
+        dist[i] = DIST_FAIXA_INF;
+    for (int v = 0; v < n; v++)
+        st[v].pos = -1;
+    heap->size = 0;
+    for (int j = 0; j < k; j++)
+    {
+        int s = sources[j];
+        dist[(size_t)s * faixas + j] = 0;
+        if (st[s].pos < 0)
+        {
+            st[s].dist = 0;
+            heap_insert(heap, s);
+        }
+    }
+    while (heap->size > 0)
+    {
+        int u = extract_min(heap);
+        st[u].pos = -1;
+        const int *du = dist + (size_t)u * faixas;
+        const Edge *e = g->vertices[u].edges;
+        for (int i = 0; i < g->vertices[u].edge_count; i++)
+        {
+            int v = e[i].dest;
+            int chave = relaxar(dist + (size_t)v * faixas, du, e[i].weight);
+            if (chave == INF)
+                continue;
+            if (st[v].pos < 0)
+            {
+                st[v].dist = chave;
+                heap_insert(heap, v);
+            }
+            else if (chave < st[v].dist)
+                decrease_key(heap, v, chave);
+        }
+    }
+    for (int j = 0; j < k; j++)
+    {
+        int *linha = tabela + (size_t)(linha0 + j) * n;
+        for (int v = 0; v < n; v++)
+        {
+            int d = dist[(size_t)v * faixas + j];
+            linha[v] = d >= DIST_FAIXA_INF ? INF : d;
+        }
+    }
+}
+
+// Distâncias de cada uma das k origens a todos os vértices: linha i da tabela
+// (k x n) é a saída de dijkstra(g, sources[i]). Pesos que poderiam somar
+// acima do infinito interno caem para uma busca por origem.
+int *multi_source_dijkstra(Graph *g, const int *sources, int k)
+{
+    int n = g->n;
+    int *tabela = malloc(((size_t)k * n > 0 ? (size_t)k * n : 1) * sizeof(int));
+    RelaxarFaixas relaxar;
+    const char *nome;
+    int faixas = escolher_faixas(&relaxar, &nome);
+    if (g->min_weight < 0 || (long long)g->max_weight * (n > 1 ? n - 1 : 1) >= DIST_FAIXA_INF)
+    {
+        for (int i = 0; i < k; i++)
+        {
+            int *d = dijkstra(g, sources[i]);
+            memcpy(tabela + (size_t)i * n, d, n * sizeof(int));
+            free(d);
+        }
+        return tabela;
+    }
+    int *dist = alocar(((size_t)n * faixas > 0 ? (size_t)n * faixas : 1) * sizeof(int), MEMORIA_BUSCA);
+    VertexState *st = alocar((n > 0 ? n : 1) * sizeof(VertexState), MEMORIA_BUSCA);
+    MinHeap heap = {alocar((n > 0 ? n : 1) * sizeof(int), MEMORIA_BUSCA), st, 0};
+    for (int i = 0; i < k; i += faixas)
+    {
+        int grupo = k - i < faixas ? k - i : faixas;
+        multi_source_group(g, sources + i, grupo, faixas, relaxar, dist, st, &heap, tabela, i);
+    }
+    liberar(dist);
+    liberar(st);
+    liberar(heap.nodes);
+    return tabela;
+}
+
+// Cache de árvores de caminhos mínimos por origem, para tráfego em que as
+// mesmas origens se repetem. As entradas são pré-alocadas dentro de um
+// orçamento de memória e nunca liberadas enquanto o cache existe; a leitura
+// não usa trava: o leitor prende a entrada incrementando refs e confere se
+// ela ainda é da origem pedida. O despejo segue o algoritmo do relógio
+// (CLOCK) e só recicla entradas sem leitores (refs 0 -> -1).
+typedef struct
+{
+    int source; // -1 se livre
+    int refs;   // leitores presos; -1 enquanto é reciclada
+    int usado;  // bit de referência do relógio
+    int settled; // vértices alcançados
+    int maior;   // maior distância finita
+    int *dist;   // distâncias no componente da origem, na ordem de componente_de()
+    int *pred;   // idem, antecessores globais; NULL se o cache não guarda antecessores
+} SptEntry;
+
+typedef struct
+{
+    int n;
+    int capacidade;
+    SptEntry *entradas;
+    int *slot_de; // entrada de cada origem, ou -1
+    unsigned ponteiro; // ponteiro do relógio
+    long long hits;
+    long long misses;
+    long long evictions;
+} SptCache;
+
+// Quantas árvores cabem no orçamento (ao menos uma)
+void spt_cache_init(SptCache *c, int n, size_t orcamento, int com_pred)
+{
+    size_t por_arvore = (size_t)n * sizeof(int) * (com_pred ? 2 : 1);
+    size_t cabem = por_arvore > 0 ? orcamento / por_arvore : 1;
+    if (cabem < 1)
+        cabem = 1;
+    if (cabem > (size_t)n)
+        cabem = n > 0 ? n : 1; // nunca há mais origens que vértices
+    c->n = n;
+    c->capacidade = (int)cabem;
+    c->entradas = calloc(c->capacidade, sizeof(SptEntry));
+    for (int k = 0; k < c->capacidade; k++)
+    {
+        c->entradas[k].source = -1;
+        c->entradas[k].dist = alocar((n > 0 ? n : 1) * sizeof(int), MEMORIA_BUSCA);
+        c->entradas[k].pred = com_pred ? alocar((n > 0 ? n : 1) * sizeof(int), MEMORIA_BUSCA) : NULL;
+    }
+    c->slot_de = malloc((n > 0 ? n : 1) * sizeof(int));
+    for (int v = 0; v < n; v++)
+        c->slot_de[v] = -1;
+    c->ponteiro = 0;
+    c->hits = c->misses = c->evictions = 0;
+}
+
+void spt_cache_free(SptCache *c)
+{
+    for (int k = 0; k < c->capacidade; k++)
+    {
+        liberar(c->entradas[k].dist);
+        liberar(c->entradas[k].pred);
+    }
+    free(c->entradas);
+    free(c->slot_de);
+}
+
+// Árvore de source presa para leitura, ou NULL (falta). Toda entrada
+// devolvida precisa de spt_cache_release.
+const SptEntry *spt_cache_acquire(SptCache *c, int source)
+{
+    int k = __atomic_load_n(&c->slot_de[source], __ATOMIC_ACQUIRE);
+    if (k >= 0)
+    {
+        SptEntry *e = &c->entradas[k];
+        int refs = __atomic_load_n(&e->refs, __ATOMIC_ACQUIRE);
+        while (refs >= 0 && !__atomic_compare_exchange_n(&e->refs, &refs, refs + 1, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+            ;
+        if (refs >= 0)
+        {
+            if (__atomic_load_n(&e->source, __ATOMIC_ACQUIRE) == source)
+            {
+                __atomic_store_n(&e->usado, 1, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&c->hits, 1, __ATOMIC_RELAXED);
+                return e;
+            }
+            __atomic_fetch_sub(&e->refs, 1, __ATOMIC_RELEASE); // reciclada para outra origem
+        }
+    }
+    __atomic_fetch_add(&c->misses, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+void spt_cache_release(const SptEntry *e)
+{
+    __atomic_fetch_sub(&((SptEntry *)e)->refs, 1, __ATOMIC_RELEASE);
+}
+
+// Guarda a última consulta completa de ws (a partir de source), só o
+// componente da origem. Se todas as entradas estiverem presas por leitores, a
+// árvore simplesmente não é guardada.
+void spt_cache_store(SptCache *c, const Graph *g, int source, const DijkstraWorkspace *ws)
+{
+    if (__atomic_load_n(&c->slot_de[source], __ATOMIC_ACQUIRE) >= 0)
+        return;
+    for (int tentativa = 0; tentativa < 2 * c->capacidade; tentativa++)
+    {
+        int k = (int)(__atomic_fetch_add(&c->ponteiro, 1, __ATOMIC_RELAXED) % (unsigned)c->capacidade);
+        SptEntry *e = &c->entradas[k];
+        if (__atomic_exchange_n(&e->usado, 0, __ATOMIC_RELAXED))
+            continue; // segunda chance
+        int livre = 0;
+        if (!__atomic_compare_exchange_n(&e->refs, &livre, -1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            continue;
+        // Entrada exclusiva: desliga a origem antiga antes de sobrescrever
+        int antiga = e->source;
+        if (antiga >= 0)
+        {
+            int slot = k;
+            __atomic_compare_exchange_n(&c->slot_de[antiga], &slot, -1, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            __atomic_store_n(&e->source, -1, __ATOMIC_RELEASE);
+            __atomic_fetch_add(&c->evictions, 1, __ATOMIC_RELAXED);
+        }
+        int maior, alcancados = 0;
+        int cn = workspace_componente(ws, g, source, e->dist, &maior);
+        const int *membros = componente_de(g, source);
+        for (int i = 0; i < cn; i++)
+        {
+            int v = membros ? membros[i] : i;
+            if (e->pred)
+                e->pred[i] = e->dist[i] == INF || v == source ? -1 : ws->state[v].pred;
+            alcancados += e->dist[i] != INF;
+        }
+        e->settled = alcancados;
+        e->maior = maior;
+        int vazio = -1;
+        if (__atomic_compare_exchange_n(&c->slot_de[source], &vazio, k, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+            __atomic_store_n(&e->source, source, __ATOMIC_RELEASE);
+            __atomic_store_n(&e->usado, 1, __ATOMIC_RELAXED);
+        }
+        // Senão outra thread publicou a mesma origem antes: a entrada fica livre
+        __atomic_store_n(&e->refs, 0, __ATOMIC_RELEASE);
+        return;
+    }
+}
+
+// Consulta de um lote: target >= 0 pede só dist(source, target), com parada
+// antecipada; target < 0 pede o SSSP completo a partir de source
+typedef struct
+{
+    int source;
+    int target;
+    int *dist_out; // SSSP: se não for NULL, recebe as distâncias do componente de source (ver componente_de())
+} Query;
+
+typedef struct
+{
+    int dist;    // s->t: a distância (INF se inalcançável); SSSP: a maior distância finita
+    int settled; // vértices assentados pela consulta
+} QueryResult;
+
+#define DEQUE_VAZIO -1
+
+// Deque de Chase-Lev: o dono empilha e desempilha em bottom, os ladrões
+// roubam em top. As consultas são empilhadas antes de o lote começar, então
+// os itens não mudam enquanto há concorrência.
+typedef struct
+{
+    long top;
+    long bottom;
+    int *items;
+    long capacity;
+} WorkDeque;
+
+static void deque_reset(WorkDeque *dq, long capacity)
+{
+    if (capacity > dq->capacity)
+    {
+        free(dq->items);
+        dq->items = malloc(capacity * sizeof(int));
+        dq->capacity = capacity;
+    }
+    dq->top = 0;
+    dq->bottom = 0;
+}
+
+static void deque_push(WorkDeque *dq, int item)
+{
+    dq->items[dq->bottom] = item;
+    __atomic_store_n(&dq->bottom, dq->bottom + 1, __ATOMIC_RELEASE);
+}
+
+static int deque_pop(WorkDeque *dq)
+{
+    long b = __atomic_load_n(&dq->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&dq->bottom, b, __ATOMIC_SEQ_CST);
+    long t = __atomic_load_n(&dq->top, __ATOMIC_SEQ_CST);
+    if (t > b)
+    {
+        __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+        return DEQUE_VAZIO;
+    }
+    int item = dq->items[b];
+    if (t == b)
+    {
+        // Último item: disputa com os ladrões pelo top
+        if (!__atomic_compare_exchange_n(&dq->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            item = DEQUE_VAZIO;
+        __atomic_store_n(&dq->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return item;
+}
+
+static int deque_steal(WorkDeque *dq)
+{
+    long t = __atomic_load_n(&dq->top, __ATOMIC_SEQ_CST);
+    long b = __atomic_load_n(&dq->bottom, __ATOMIC_SEQ_CST);
+    if (t >= b)
+        return DEQUE_VAZIO;
+    int item = dq->items[t];
+    if (!__atomic_compare_exchange_n(&dq->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return DEQUE_VAZIO;
+    return item;
+}
+
+// Topologia NUMA lida de /sys: os nós com CPUs e o conjunto de CPUs de cada um.
+// Fora do Linux, ou sem /sys, a máquina é tratada como um único nó.
+typedef struct
+{
+    int num_nodes;
+#ifdef __linux__
+    cpu_set_t *cpus;
+#endif
+} NumaTopology;
+
+// Lê listas no formato do kernel ("0-3,8,10-11") para saida; retorna quantos
+static int ler_lista_intervalos(const char *texto, int *saida, int max)
+{
+    int quantos = 0;
+    const char *p = texto;
+    while (*p >= '0' && *p <= '9')
+    {
+        char *fim;
+        long a = strtol(p, &fim, 10), b = a;
+        if (*fim == '-')
+            b = strtol(fim + 1, &fim, 10);
+        for (long x = a; x <= b && quantos < max; x++)
+            saida[quantos++] = (int)x;
+        p = *fim == ',' ? fim + 1 : fim;
+    }
+    return quantos;
+}
+
+static int ler_arquivo_curto(const char *caminho, char *texto, size_t tamanho)
+{
+    FILE *f = fopen(caminho, "r");
+    if (!f)
+        return 0;
+    size_t lidos = fread(texto, 1, tamanho - 1, f);
+    texto[lidos] = '\0';
+    fclose(f);
+    return lidos > 0;
+}
+
+// Topologia lida de $DIJKSTRA_SYSFS/devices/system/node (padrão /sys), o que
+// permite exercitar o caminho com vários nós numa árvore montada à mão
+void numa_topology_init(NumaTopology *topo)
+{
+    topo->num_nodes = 1;
+#ifdef __linux__
+    topo->cpus = NULL;
+    const char *raiz = getenv("DIJKSTRA_SYSFS");
+    if (!raiz || !*raiz)
+        raiz = "/sys";
+    char texto[4096], caminho[512];
+    int nos[256], cpus[CPU_SETSIZE];
+    snprintf(caminho, sizeof(caminho), "%s/devices/system/node/online", raiz);
+    if (!ler_arquivo_curto(caminho, texto, sizeof(texto)))
+        return;
+    int online = ler_lista_intervalos(texto, nos, 256);
+    if (online <= 1)
+        return;
+    cpu_set_t *conjuntos = calloc(online, sizeof(cpu_set_t));
+    int com_cpus = 0;
+    for (int i = 0; i < online; i++)
+    {
+        snprintf(caminho, sizeof(caminho), "%s/devices/system/node/node%d/cpulist", raiz, nos[i]);
+        if (!ler_arquivo_curto(caminho, texto, sizeof(texto)))
+            continue;
+        int quantas = ler_lista_intervalos(texto, cpus, CPU_SETSIZE);
+        CPU_ZERO(&conjuntos[com_cpus]);
+        for (int c = 0; c < quantas; c++)
+            if (cpus[c] >= 0 && cpus[c] < CPU_SETSIZE)
+                CPU_SET(cpus[c], &conjuntos[com_cpus]);
+        if (CPU_COUNT(&conjuntos[com_cpus]) == 0)
+            continue; // nó só de memória (ou CPUs fora de cpu_set_t)
+        com_cpus++;
+    }
+    if (com_cpus <= 1)
+    {
+        free(conjuntos);
+        return;
+    }
+    topo->num_nodes = com_cpus;
+    topo->cpus = conjuntos;
+#endif
+}
+
+void numa_topology_free(NumaTopology *topo)
+{
+#ifdef __linux__
+    free(topo->cpus);
+    topo->cpus = NULL;
+#endif
+    topo->num_nodes = 1;
+}
+
+// Restringe a thread atual às CPUs do nó; sem efeito com um único nó
+void fixar_no_numa(const NumaTopology *topo, int no)
+{
+#ifdef __linux__
+    if (topo->num_nodes > 1)
+        sched_setaffinity(0, sizeof(cpu_set_t), &topo->cpus[no]);
+#else
+    (void)topo;
+    (void)no;
+#endif
+}
+
+// DIJKSTRA_NUMA=desligado desliga as réplicas por nó
+int replicacao_numa_pedida()
+{
+    const char *modo = getenv("DIJKSTRA_NUMA");
+    return !modo || strcmp(modo, "desligado") != 0;
+}
+
+typedef struct
+{
+    const Graph *original;
+    Graph *replica;
+    const NumaTopology *topo;
+    int no;
+} ReplicaNuma;
+
+static void *criar_replica_numa(void *arg)
+{
+    ReplicaNuma *r = arg;
+    fixar_no_numa(r->topo, r->no);
+    copiar_grafo(r->replica, r->original);
+    return NULL;
+}
+
+typedef struct BatchExecutor BatchExecutor;
+
+typedef struct
+{
+    BatchExecutor *ex;
+    int id;
+    int no;   // nó NUMA do worker
+    Graph *g; // réplica local do grafo (ou o original)
+    pthread_t thread;
+    DijkstraWorkspace ws;
+    WorkDeque deque;
+    unsigned int semente; // sorteio da vítima de roubo
+    long long steals;
+} BatchWorker;
+
+// Pool de threads persistente sobre um grafo que não muda durante os lotes;
+// cada worker tem sua área de trabalho e seu deque. Com mais de um nó NUMA,
+// cada nó recebe uma réplica do grafo e os workers ficam presos ao seu nó.
+struct BatchExecutor
+{
+    Graph *g;
+    NumaTopology topo;
+    Graph *replicas; // uma por nó, ou NULL sem replicação
+    int nthreads;
+    BatchWorker *workers;
+    pthread_mutex_t lock;
+    pthread_cond_t inicio;
+    pthread_cond_t fim;
+    int geracao; // incrementada a cada lote
+    int ativos;  // workers que ainda não terminaram o lote atual
+    int encerrar;
+    const Query *queries;
+    QueryResult *results;
+    SptCache *cache; // opcional: árvores já calculadas, por origem
+};
+
+// Com cache, uma falta roda o SSSP completo da origem e o guarda; um acerto
+// responde direto da árvore guardada, sem busca (0 vértices assentados para s->t)
+static void executar_consulta_cache(SptCache *cache, DijkstraWorkspace *ws, Graph *g, const Query *q, QueryResult *r)
+{
+    const SptEntry *e = spt_cache_acquire(cache, q->source);
+    if (e)
+    {
+        r->dist = q->target >= 0 ? e->dist[indice_local(g, q->target)] : e->maior;
+        r->settled = q->target >= 0 ? 0 : e->settled;
+        if (q->target < 0 && q->dist_out)
+            memcpy(q->dist_out, e->dist, tamanho_componente(g, q->source) * sizeof(int));
+        spt_cache_release(e);
+        return;
+    }
+    r->settled = dijkstra_workspace(ws, g, q->source);
+    spt_cache_store(cache, g, q->source, ws);
+    if (q->target >= 0)
+        r->dist = workspace_dist(ws, q->target);
+    else
+        workspace_componente(ws, g, q->source, q->dist_out, &r->dist);
+}
+
+static void executar_consulta(DijkstraWorkspace *ws, Graph *g, SptCache *cache, const Query *q, QueryResult *r)
+{
+    r->dist = INF;
+    r->settled = 0;
+    if (q->target >= 0 && !same_component(g, q->source, q->target))
+        return;
+    if (cache)
+    {
+        executar_consulta_cache(cache, ws, g, q, r);
+        return;
+    }
+    dijkstra_workspace_reset(ws);
+    dijkstra_workspace_seed(ws, q->source, 0);
+    int u, maior = 0;
+    while ((u = dijkstra_workspace_next(ws, g)) >= 0)
+    {
+        r->settled++;
+        maior = ws->state[u].dist;
+        if (u == q->target)
+        {
+            r->dist = maior;
+            return;
+        }
+    }
+    if (q->target < 0)
+    {
+        r->dist = maior;
+        if (q->dist_out)
+            workspace_componente(ws, g, q->source, q->dist_out, &maior);
+    }
+}
+
+// Deques só recebem consultas antes do lote começar: visto vazio, um deque
+// não volta a ter o que roubar até o próximo lote
+static int deques_vazios(BatchExecutor *ex)
+{
+    for (int t = 0; t < ex->nthreads; t++)
+    {
+        WorkDeque *dq = &ex->workers[t].deque;
+        if (__atomic_load_n(&dq->top, __ATOMIC_SEQ_CST) < __atomic_load_n(&dq->bottom, __ATOMIC_SEQ_CST))
+            return 0;
+    }
+    return 1;
+}
+
+// Próxima consulta do worker: do próprio deque ou roubada de outro. Quando
+// não sobra nada para roubar, o worker desiste do lote e dorme em
+// ex->inicio até o próximo, em vez de girar enquanto os outros terminam
+// as consultas em andamento.
+static int proxima_consulta(BatchWorker *w)
+{
+    BatchExecutor *ex = w->ex;
+    int item = deque_pop(&w->deque);
+    for (int giro = 0; item == DEQUE_VAZIO && ex->nthreads > 1; giro++)
+    {
+        int vitima = rand_r(&w->semente) % (ex->nthreads - 1);
+        if (vitima >= w->id)
+            vitima++;
+        item = deque_steal(&ex->workers[vitima].deque);
+        if (item != DEQUE_VAZIO)
+            w->steals++;
+        else if (giro % ex->nthreads == ex->nthreads - 1 && deques_vazios(ex))
+            break;
+        else
+            espera_curta(giro);
+    }
+    return item;
+}
+
+static void *batch_worker(void *arg)
+{
+    BatchWorker *w = arg;
+    BatchExecutor *ex = w->ex;
+    int geracao = 0;
+    // Fixada ao nó antes de alocar, a área de trabalho fica na memória local
+    fixar_no_numa(&ex->topo, w->no);
+    dijkstra_workspace_init(&w->ws, w->g->n);
+    pthread_mutex_lock(&ex->lock);
+    if (--ex->ativos == 0)
+        pthread_cond_signal(&ex->fim);
+    pthread_mutex_unlock(&ex->lock);
+    while (1)
+    {
+        pthread_mutex_lock(&ex->lock);
+        while (ex->geracao == geracao && !ex->encerrar)
+            pthread_cond_wait(&ex->inicio, &ex->lock);
+        if (ex->encerrar)
+        {
+            pthread_mutex_unlock(&ex->lock);
+            return NULL;
+        }
+        geracao = ex->geracao;
+        pthread_mutex_unlock(&ex->lock);
+
+        int i;
+        while ((i = proxima_consulta(w)) != DEQUE_VAZIO)
+        {
+            executar_consulta(&w->ws, w->g, ex->cache, &ex->queries[i], &ex->results[i]);
+        }
+
+        pthread_mutex_lock(&ex->lock);
+        if (--ex->ativos == 0)
+            pthread_cond_signal(&ex->fim);
+        pthread_mutex_unlock(&ex->lock);
+    }
+}
+
+void batch_executor_init(BatchExecutor *ex, Graph *g, int nthreads)
+{
+    ex->g = g;
+    ex->nthreads = nthreads > 0 ? nthreads : 1;
+    ex->workers = calloc(ex->nthreads, sizeof(BatchWorker));
+    pthread_mutex_init(&ex->lock, NULL);
+    pthread_cond_init(&ex->inicio, NULL);
+    pthread_cond_init(&ex->fim, NULL);
+    ex->geracao = 0;
+    ex->encerrar = 0;
+    ex->cache = NULL;
+    numa_topology_init(&ex->topo);
+    ex->replicas = NULL;
+    if (ex->topo.num_nodes > 1 && replicacao_numa_pedida())
+    {
+        // Cada réplica é copiada por uma thread presa ao próprio nó
+        ex->replicas = calloc(ex->topo.num_nodes, sizeof(Graph));
+        ReplicaNuma *pedidos = malloc(ex->topo.num_nodes * sizeof(ReplicaNuma));
+        pthread_t *threads = malloc(ex->topo.num_nodes * sizeof(pthread_t));
+        for (int k = 0; k < ex->topo.num_nodes; k++)
+        {
+            pedidos[k] = (ReplicaNuma){g, &ex->replicas[k], &ex->topo, k};
+            pthread_create(&threads[k], NULL, criar_replica_numa, &pedidos[k]);
+        }
+        for (int k = 0; k < ex->topo.num_nodes; k++)
+            pthread_join(threads[k], NULL);
+        free(pedidos);
+        free(threads);
+    }
+    ex->ativos = ex->nthreads;
+    for (int t = 0; t < ex->nthreads; t++)
+    {
+        BatchWorker *w = &ex->workers[t];
+        w->ex = ex;
+        w->id = t;
+        w->no = t % ex->topo.num_nodes;
+        w->g = ex->replicas ? &ex->replicas[w->no] : g;
+        w->semente = 12345u + t;
+        pthread_create(&w->thread, NULL, batch_worker, w);
+    }
+    // Espera as áreas de trabalho, alocadas por cada worker no seu nó
+    pthread_mutex_lock(&ex->lock);
+    while (ex->ativos > 0)
+        pthread_cond_wait(&ex->fim, &ex->lock);
+    pthread_mutex_unlock(&ex->lock);
+}
+
+// Executa o lote e espera todas as consultas; results[i] é a resposta de
+// queries[i], na ordem de submissão. Retorna o número de roubos.
+long long batch_executor_run(BatchExecutor *ex, const Query *queries, int count, QueryResult *results)
+{
+    // Blocos contíguos por worker; o desequilíbrio é corrigido pelos roubos
+    for (int t = 0; t < ex->nthreads; t++)
+    {
+        BatchWorker *w = &ex->workers[t];
+        int ini = (int)((long long)count * t / ex->nthreads);
+        int fim = (int)((long long)count * (t + 1) / ex->nthreads);
+        deque_reset(&w->deque, fim - ini > 0 ? fim - ini : 1);
+        for (int i = fim - 1; i >= ini; i--)
+            deque_push(&w->deque, i);
+        w->steals = 0;
+    }
+    pthread_mutex_lock(&ex->lock);
+    ex->queries = queries;
+    ex->results = results;
+    ex->ativos = ex->nthreads;
+    ex->geracao++;
+    pthread_cond_broadcast(&ex->inicio);
+    while (ex->ativos > 0)
+        pthread_cond_wait(&ex->fim, &ex->lock);
+    pthread_mutex_unlock(&ex->lock);
+
+    long long steals = 0;
+    for (int t = 0; t < ex->nthreads; t++)
+        steals += ex->workers[t].steals;
+    return steals;
+}
+
+void batch_executor_free(BatchExecutor *ex)
+{
+    pthread_mutex_lock(&ex->lock);
+    ex->encerrar = 1;
+    pthread_cond_broadcast(&ex->inicio);
+    pthread_mutex_unlock(&ex->lock);
+    for (int t = 0; t < ex->nthreads; t++)
+    {
+        pthread_join(ex->workers[t].thread, NULL);
+        dijkstra_workspace_free(&ex->workers[t].ws);
+        free(ex->workers[t].deque.items);
+    }
+    free(ex->workers);
+    if (ex->replicas)
+        for (int k = 0; k < ex->topo.num_nodes; k++)
+            free_graph(&ex->replicas[k]);
+    free(ex->replicas);
+    numa_topology_free(&ex->topo);
+    pthread_mutex_destroy(&ex->lock);
+    pthread_cond_destroy(&ex->inicio);
+    pthread_cond_destroy(&ex->fim);
+}
+
+// Consultas intercaladas numa só thread (AMAC): cada consulta é uma máquina
+// de estados que, antes de tocar a memória que vai precisar (lista de arestas
+// do vértice assentado, estado dos vizinhos), emite um prefetch e cede a vez
+// à próxima consulta. Quando a vez volta, os dados já estão na cache.
+enum
+{
+    ETAPA_LIVRE,
+    ETAPA_EXTRAIR,  // tira a raiz do heap e busca os filhos da nova raiz
+    ETAPA_DESCER,   // desce um nível do heap com os filhos já trazidos
+    ETAPA_VIZINHOS, // busca o estado do próximo bloco de vizinhos
+    ETAPA_RELAXAR   // relaxa o bloco já trazido
+};
+
+#define BLOCO_VIZINHOS 8
+
+typedef struct
+{
+    DijkstraWorkspace ws;
+    int etapa;
+    int consulta;
+    int u;
+    int du;
+    int i;
+    int fim_bloco;
+    int maior;
+    int h; // posição no heap durante a descida
+} QueryCoroutine;
+
+// Prefetch do estado dos filhos da posição i do heap
+static void buscar_filhos(const MinHeap *heap, int i)
+{
+    int l = 2 * i + 1;
+    if (l < heap->size)
+        __builtin_prefetch(&heap->state[heap->nodes[l]]);
+    if (l + 1 < heap->size)
+        __builtin_prefetch(&heap->state[heap->nodes[l + 1]]);
+}
+
+static void iniciar_corrotina(QueryCoroutine *c, Graph *g, const Query *queries, QueryResult *results, int consulta)
+{
+    const Query *q = &queries[consulta];
+    QueryResult *r = &results[consulta];
+    c->consulta = consulta;
+    c->maior = 0;
+    r->dist = INF;
+    r->settled = 0;
+    if (q->target >= 0 && !same_component(g, q->source, q->target))
+    {
+        c->etapa = ETAPA_LIVRE; // respondida sem busca
+        return;
+    }
+    dijkstra_workspace_reset(&c->ws);
+    dijkstra_workspace_seed(&c->ws, q->source, 0);
+    c->etapa = ETAPA_EXTRAIR;
+}
+
+// Avança uma etapa; retorna 1 se a consulta terminou
+static int passo_corrotina(QueryCoroutine *c, Graph *g, const Query *q, QueryResult *r)
+{
+    DijkstraWorkspace *ws = &c->ws;
+    switch (c->etapa)
+    {
+    case ETAPA_EXTRAIR:
+        if (ws->heap.size == 0)
+        {
+            if (q->target < 0)
+            {
+                r->dist = c->maior;
+                if (q->dist_out)
+                    workspace_componente(ws, g, q->source, q->dist_out, &c->maior);
+            }
+            return 1;
+        }
+    {
+        // extract_min em etapas: a descida pelo heap é a parte cara
+        MinHeap *heap = &ws->heap;
+        c->u = heap->nodes[0];
+        heap->nodes[0] = heap->nodes[--heap->size];
+        heap->state[heap->nodes[0]].pos = 0;
+        c->du = ws->state[c->u].dist;
+        ws->state[c->u].pos = SETTLED;
+        r->settled++;
+        c->maior = c->du;
+        if (c->u == q->target)
+        {
+            r->dist = c->du;
+            return 1;
+        }
+        c->h = 0;
+        buscar_filhos(heap, 0);
+        __builtin_prefetch(g->vertices[c->u].edges);
+        c->etapa = ETAPA_DESCER;
+        return 0;
+    }
+    case ETAPA_DESCER:
+    {
+        MinHeap *heap = &ws->heap;
+        VertexState *st = heap->state;
+        int i = c->h, menor = i, l = 2 * i + 1, d = l + 1;
+        if (l < heap->size && st[heap->nodes[l]].dist < st[heap->nodes[menor]].dist)
+            menor = l;
+        if (d < heap->size && st[heap->nodes[d]].dist < st[heap->nodes[menor]].dist)
+            menor = d;
+        if (menor != i)
+        {
+            st[heap->nodes[i]].pos = menor;
+            st[heap->nodes[menor]].pos = i;
+            swap(&heap->nodes[i], &heap->nodes[menor]);
+            c->h = menor;
+            buscar_filhos(heap, menor);
+            return 0;
+        }
+        c->i = 0;
+        c->etapa = ETAPA_VIZINHOS;
+        return passo_corrotina(c, g, q, r);
+    }
+    case ETAPA_VIZINHOS:
+    {
+        const AdjList *list = &g->vertices[c->u];
+        if (c->i >= list->edge_count)
+        {
+            c->etapa = ETAPA_EXTRAIR;
+            return passo_corrotina(c, g, q, r);
+        }
+        c->fim_bloco = c->i + BLOCO_VIZINHOS < list->edge_count ? c->i + BLOCO_VIZINHOS : list->edge_count;
+        for (int k = c->i; k < c->fim_bloco; k++)
+            __builtin_prefetch(&ws->state[list->edges[k].dest], 1);
+        if (c->fim_bloco < list->edge_count)
+            __builtin_prefetch(&list->edges[c->fim_bloco]);
+        c->etapa = ETAPA_RELAXAR;
+        return 0;
+    }
+    case ETAPA_RELAXAR:
+    {
+        const Edge *e = g->vertices[c->u].edges;
+        for (; c->i < c->fim_bloco; c->i++)
+            dijkstra_workspace_relax(ws, c->u, e[c->i].dest, c->du + e[c->i].weight);
+        c->etapa = ETAPA_VIZINHOS;
+        return 0;
+    }
+    }
+    return 1;
+}
+
+// Responde as consultas com largura corrotinas em andamento ao mesmo tempo,
+// alternando entre elas a cada etapa; results[i] corresponde a queries[i]
+void interleaved_queries(Graph *g, const Query *queries, int count, QueryResult *results, int largura)
+{
+    if (largura < 1)
+        largura = 1;
+    QueryCoroutine *c = calloc(largura, sizeof(QueryCoroutine));
+    for (int k = 0; k < largura; k++)
+    {
+        dijkstra_workspace_init(&c[k].ws, g->n);
+        c[k].etapa = ETAPA_LIVRE;
+    }
+    int proxima = 0, ativas = 0;
+    do
+    {
+        ativas = 0;
+        for (int k = 0; k < largura; k++)
+        {
+            // Vaga livre: puxa a próxima consulta (algumas terminam na hora)
+            while (c[k].etapa == ETAPA_LIVRE && proxima < count)
+                iniciar_corrotina(&c[k], g, queries, results, proxima++);
+            if (c[k].etapa == ETAPA_LIVRE)
+                continue;
+            ativas++;
+            if (passo_corrotina(&c[k], g, &queries[c[k].consulta], &results[c[k].consulta]))
+                c[k].etapa = ETAPA_LIVRE;
+        }
+    } while (ativas > 0 || proxima < count);
+    for (int k = 0; k < largura; k++)
+        dijkstra_workspace_free(&c[k].ws);
+    free(c);
+}
+
+typedef struct
+{
+    int *nodes;
+    int length;
+    int cost;
+} Path;
+
+void free_paths(Path *paths, int count)
+{
+    for (int i = 0; i < count; i++)
+        free(paths[i].nodes);
+}
+
+// Caminho mínimo source->target na busca esparsa (respeitando a máscara ativa),
+// com prefix (prefix_len vértices, custo prefix_cost) antes de source
+static int caminho_desvio(SparseSearch *ss, Graph *g, const int *prefix, int prefix_len, int prefix_cost, int source, int target, Path *out)
+{
+    int u;
+    sparse_search_start(ss, source);
+    while ((u = sparse_search_next(ss, g, INF)) >= 0 && u != target)
+        ;
+    if (u != target)
+        return 0;
+    int len = workspace_path(&ss->ws, source, target, NULL, 0);
+    out->length = prefix_len + len;
+    out->nodes = malloc(out->length * sizeof(int));
+    if (prefix_len > 0)
+        memcpy(out->nodes, prefix, prefix_len * sizeof(int));
+    workspace_path(&ss->ws, source, target, out->nodes + prefix_len, len);
+    out->cost = prefix_cost + ss->ws.state[target].dist;
+    return 1;
+}
+
+static int mesmo_caminho(const Path *a, const Path *b)
+{
+    return a->length == b->length && memcmp(a->nodes, b->nodes, a->length * sizeof(int)) == 0;
+}
+
+// k caminhos simples mais curtos de source a target (Yen). Cada busca de
+// desvio reaproveita o estado esparso de ss e bloqueia vértices da raiz e
+// arcos já usados por máscaras preguiçosas, sem copiar o grafo. Preenche
+// paths (capacidade k) em ordem crescente de custo e retorna quantos achou.
+int k_shortest_paths(SparseSearch *ss, Graph *g, int source, int target, int k, Path *paths)
+{
+    if (k <= 0 || !same_component(g, source, target) || !caminho_desvio(ss, g, NULL, 0, 0, source, target, &paths[0]))
+        return 0;
+    int encontrados = 1;
+    Path *candidatos = NULL;
+    int num_candidatos = 0, cap_candidatos = 0;
+
+    while (encontrados < k)
+    {
+        Path *anterior = &paths[encontrados - 1];
+        int custo_raiz = 0;
+        for (int i = 0; i + 1 < anterior->length; i++)
+        {
+            int spur = anterior->nodes[i];
+            sparse_search_mask_reset(ss, spur);
+            for (int j = 0; j < i; j++)
+                ss->blocked[anterior->nodes[j]] = ss->block_epoch;
+            for (int p = 0; p < encontrados; p++)
+                if (paths[p].length > i + 1 && memcmp(paths[p].nodes, anterior->nodes, (i + 1) * sizeof(int)) == 0)
+                    sparse_search_block_edge(ss, paths[p].nodes[i + 1]);
+
+            Path novo;
+            if (caminho_desvio(ss, g, anterior->nodes, i, custo_raiz, spur, target, &novo))
+            {
+                int repetido = 0;
+                for (int c = 0; c < num_candidatos && !repetido; c++)
+                    repetido = mesmo_caminho(&candidatos[c], &novo);
+                if (repetido)
+                    free(novo.nodes);
+                else
+                {
+                    if (num_candidatos == cap_candidatos)
+                    {
+                        cap_candidatos = cap_candidatos ? cap_candidatos * 2 : 8;
+                        candidatos = realloc(candidatos, cap_candidatos * sizeof(Path));
+                    }
+                    candidatos[num_candidatos++] = novo;
+                }
+            }
+            custo_raiz += peso_arco(g, spur, anterior->nodes[i + 1]);
+        }
+        ss->masking = 0;
+
+        if (num_candidatos == 0)
+            break;
+        int melhor = 0;
+        for (int c = 1; c < num_candidatos; c++)
+            if (candidatos[c].cost < candidatos[melhor].cost)
+                melhor = c;
+        paths[encontrados++] = candidatos[melhor];
+        candidatos[melhor] = candidatos[--num_candidatos];
+    }
+
+    free_paths(candidatos, num_candidatos);
+    free(candidatos);
+    return encontrados;
+}
+
+// Pré-processamento para grafos não direcionados: folhas (grau 1) são
+// removidas repetidamente e cadeias de vértices de grau 2 viram uma única
+// aresta entre as pontas. As consultas rodam só no núcleo que sobra e as
+// distâncias dos vértices removidos são recuperadas numa varredura linear.
+typedef struct
+{
+    Graph *g;
+    Graph core;
+    int *core_id;     // vértice -> índice no núcleo (-1 se foi removido)
+    int *core_vertex; // índice no núcleo -> vértice
+    // Árvores penduradas: parent[v] é o único vizinho que restava quando v
+    // foi removido como folha (-1 se não foi); peel_order é a ordem de remoção
+    int *parent;
+    int *parent_weight;
+    int *peel_order;
+    int peeled;
+    // Cadeias: chain_vertices[chain_start[c] .. chain_start[c + 1]) são os
+    // vértices internos da cadeia c, de chain_a[c] a chain_b[c], e
+    // chain_offset[v] é a distância de v até chain_a pela própria cadeia
+    int *chain;
+    int *chain_offset;
+    int *chain_start;
+    int *chain_vertices;
+    int *chain_a;
+    int *chain_b;
+    int *chain_length;
+    int num_chains;
+} ContractedGraph;
+
+// Vizinho ainda presente de v diferente de anterior (-1 se não houver)
+static int outro_vizinho(Graph *g, const char *vivo, int v, int anterior)
+{
+    AdjList *list = &g->vertices[v];
+    for (int i = 0; i < list->edge_count; i++)
+    {
+        int u = list->edges[i].dest;
+        if (u != v && u != anterior && vivo[u])
+            return u;
+    }
+    return -1;
+}
+
+// Percorre a cadeia que sai da ponta a pelo vizinho y até a próxima ponta
+static void seguir_cadeia(ContractedGraph *cg, const char *vivo, int a, int y, int *total)
+{
+    Graph *g = cg->g;
+    int c = cg->num_chains++;
+    cg->chain_start[c] = *total;
+    cg->chain_a[c] = a;
+    int anterior = a, atual = y;
+    int comprimento = peso_arco(g, a, y);
+    while (cg->core_id[atual] < 0)
+    {
+        cg->chain[atual] = c;
+        cg->chain_offset[atual] = comprimento;
+        cg->chain_vertices[(*total)++] = atual;
+        int proximo = outro_vizinho(g, vivo, atual, anterior);
+        comprimento += peso_arco(g, atual, proximo);
+        anterior = atual;
+        atual = proximo;
+    }
+    cg->chain_b[c] = atual;
+    cg->chain_length[c] = comprimento;
+    cg->chain_start[c + 1] = *total;
+}
+
+// Retorna 0 (sem alocar nada) se o grafo for direcionado
+int contract_graph(ContractedGraph *cg, Graph *g)
+{
+    if (g->directed)
+        return 0;
+    int n = g->n;
+    cg->g = g;
+    cg->core_id = malloc(n * sizeof(int));
+    cg->parent = malloc(n * sizeof(int));
+    cg->parent_weight = malloc(n * sizeof(int));
+    cg->peel_order = malloc(n * sizeof(int));
+    cg->peeled = 0;
+    cg->chain = malloc(n * sizeof(int));
+    cg->chain_offset = malloc(n * sizeof(int));
+    cg->chain_start = malloc((n + 1) * sizeof(int));
+    cg->chain_vertices = malloc(n * sizeof(int));
+    cg->chain_a = malloc(n * sizeof(int));
+    cg->chain_b = malloc(n * sizeof(int));
+    cg->chain_length = malloc(n * sizeof(int));
+    cg->num_chains = 0;
+    cg->chain_start[0] = 0;
+
+    // Grau = número de vizinhos distintos (arestas paralelas e laços não contam)
+    int *grau = calloc(n, sizeof(int));
+    int *marca = malloc(n * sizeof(int));
+    char *vivo = malloc(n);
+    for (int v = 0; v < n; v++)
+    {
+        marca[v] = -1;
+        vivo[v] = 1;
+        cg->parent[v] = -1;
+        cg->chain[v] = -1;
+    }
+    for (int u = 0; u < n; u++)
+        for (int i = 0; i < g->vertices[u].edge_count; i++)
+        {
+            int v = g->vertices[u].edges[i].dest;
+            if (v != u && marca[v] != u)
+            {
+                marca[v] = u;
+                grau[u]++;
+            }
+        }
+
+    // Remove folhas até sobrar o 2-core (e uma raiz por árvore isolada)
+    int *fila = marca;
+    int inicio = 0, fim = 0;
+    for (int v = 0; v < n; v++)
+        if (grau[v] == 1)
+            fila[fim++] = v;
+    while (inicio < fim)
+    {
+        int v = fila[inicio++];
+        if (grau[v] != 1)
+            continue;
+        int p = outro_vizinho(g, vivo, v, v);
+        vivo[v] = 0;
+        cg->parent[v] = p;
+        cg->parent_weight[v] = peso_arco(g, v, p);
+        cg->peel_order[cg->peeled++] = v;
+        if (--grau[p] == 1)
+            fila[fim++] = p;
+    }
+
+    // Pontas das cadeias (grau != 2) ficam no núcleo
+    for (int v = 0; v < n; v++)
+        cg->core_id[v] = vivo[v] && grau[v] != 2 ? 0 : -1;
+    int total = 0;
+    for (int a = 0; a < n; a++)
+    {
+        if (cg->core_id[a] < 0)
+            continue;
+        for (int i = 0; i < g->vertices[a].edge_count; i++)
+        {
+            int y = g->vertices[a].edges[i].dest;
+            if (vivo[y] && cg->core_id[y] < 0 && cg->chain[y] < 0)
+                seguir_cadeia(cg, vivo, a, y, &total);
+        }
+    }
+    // Ciclos só de grau 2: um vértice vira ponta dos dois lados
+    for (int v = 0; v < n; v++)
+    {
+        if (!vivo[v] || cg->core_id[v] >= 0 || cg->chain[v] >= 0)
+            continue;
+        cg->core_id[v] = 0;
+        seguir_cadeia(cg, vivo, v, outro_vizinho(g, vivo, v, v), &total);
+    }
+
+    int nc = 0;
+    for (int v = 0; v < n; v++)
+        if (cg->core_id[v] >= 0)
+            cg->core_id[v] = nc++;
+    cg->core_vertex = malloc((nc > 0 ? nc : 1) * sizeof(int));
+    for (int v = 0; v < n; v++)
+        if (cg->core_id[v] >= 0)
+            cg->core_vertex[cg->core_id[v]] = v;
+
+    init_graph(&cg->core, nc);
+    cg->core.directed = 0;
+    for (int cu = 0; cu < nc; cu++)
+    {
+        AdjList *list = &g->vertices[cg->core_vertex[cu]];
+        for (int i = 0; i < list->edge_count; i++)
+        {
+            int cv = cg->core_id[list->edges[i].dest];
+            if (cv >= 0)
+                add_edge(&cg->core, cu, cv, list->edges[i].weight);
+        }
+    }
+    for (int c = 0; c < cg->num_chains; c++)
+    {
+        int a = cg->core_id[cg->chain_a[c]], b = cg->core_id[cg->chain_b[c]];
+        if (a != b)
+        {
+            add_edge(&cg->core, a, b, cg->chain_length[c]);
+            add_edge(&cg->core, b, a, cg->chain_length[c]);
+        }
+    }
+    compactar_arestas(&cg->core);
+    compute_components(&cg->core);
+
+    free(grau);
+    free(marca);
+    free(vivo);
+    return 1;
+}
+
+void contracted_graph_free(ContractedGraph *cg)
+{
+    free_graph(&cg->core);
+    free(cg->core_id);
+    free(cg->core_vertex);
+    free(cg->parent);
+    free(cg->parent_weight);
+    free(cg->peel_order);
+    free(cg->chain);
+    free(cg->chain_offset);
+    free(cg->chain_start);
+    free(cg->chain_vertices);
+    free(cg->chain_a);
+    free(cg->chain_b);
+    free(cg->chain_length);
+}
+
+// Distâncias a partir de start no grafo original; ws deve ter o tamanho do
+// núcleo (dijkstra_workspace_init(ws, cg->core.n))
+int *contracted_dijkstra(ContractedGraph *cg, DijkstraWorkspace *ws, int start)
+{
+    Graph *g = cg->g;
+    int n = g->n;
+    int *dist = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++)
+        dist[i] = INF;
+    dist[start] = 0;
+
+    // start numa árvore pendurada: caminhos únicos até a raiz da árvore
+    int origem = start;
+    if (cg->parent[start] >= 0)
+    {
+        int *pilha = malloc(n * sizeof(int));
+        int topo = 0;
+        pilha[topo++] = start;
+        while (topo > 0)
+        {
+            int u = pilha[--topo];
+            for (int i = 0; i < g->vertices[u].edge_count; i++)
+            {
+                int v = g->vertices[u].edges[i].dest;
+                int nd = dist[u] + g->vertices[u].edges[i].weight;
+                if (dist[v] == INF)
+                {
+                    if (cg->parent[v] >= 0)
+                        pilha[topo++] = v;
+                    else
+                        origem = v;
+                }
+                if (nd < dist[v])
+                    dist[v] = nd;
+            }
+        }
+        free(pilha);
+    }
+
+    int base = dist[origem];
+    dijkstra_workspace_reset(ws);
+    int c = cg->chain[origem];
+    if (c >= 0)
+    {
+        // Origem dentro de uma cadeia: vizinhos na cadeia direto, resto pelas pontas
+        int off = cg->chain_offset[origem];
+        for (int i = cg->chain_start[c]; i < cg->chain_start[c + 1]; i++)
+        {
+            int x = cg->chain_vertices[i];
+            int d = base + abs(cg->chain_offset[x] - off);
+            if (d < dist[x])
+                dist[x] = d;
+        }
+        dijkstra_workspace_seed(ws, cg->core_id[cg->chain_a[c]], base + off);
+        dijkstra_workspace_seed(ws, cg->core_id[cg->chain_b[c]], base + cg->chain_length[c] - off);
+    }
+    else
+        dijkstra_workspace_seed(ws, cg->core_id[origem], base);
+
+    int u;
+    while ((u = dijkstra_workspace_next(ws, &cg->core)) >= 0)
+        dist[cg->core_vertex[u]] = ws->state[u].dist;
+
+    // Expansão: interiores das cadeias pelas pontas, depois as árvores da raiz às folhas
+    for (c = 0; c < cg->num_chains; c++)
+    {
+        int da = dist[cg->chain_a[c]], db = dist[cg->chain_b[c]];
+        for (int i = cg->chain_start[c]; i < cg->chain_start[c + 1]; i++)
+        {
+            int x = cg->chain_vertices[i];
+            if (da != INF && da + cg->chain_offset[x] < dist[x])
+                dist[x] = da + cg->chain_offset[x];
+            if (db != INF && db + cg->chain_length[c] - cg->chain_offset[x] < dist[x])
+                dist[x] = db + cg->chain_length[c] - cg->chain_offset[x];
+        }
+    }
+    for (int i = cg->peeled - 1; i >= 0; i--)
+    {
+        int v = cg->peel_order[i];
+        int dp = dist[cg->parent[v]];
+        if (dp != INF && dp + cg->parent_weight[v] < dist[v])
+            dist[v] = dp + cg->parent_weight[v];
+    }
+    return dist;
+}
+
+// Escolhe Δ a partir dos pesos vistos no carregamento: peso máximo / grau médio
+// (heurística de Meyer & Sanders), limitado ao intervalo [peso mínimo, peso máximo]
+int escolher_delta(Graph *g)
+{
+    if (g->m == 0 || g->n == 0)
+        return 1;
+    double grau_medio = (double)g->m / g->n;
+    int delta = (int)(g->max_weight / grau_medio);
+    if (delta > g->max_weight)
+        delta = g->max_weight;
+    if (delta < g->min_weight)
+        delta = g->min_weight;
+    if (delta < 1)
+        delta = 1;
+    return delta;
+}
+
+typedef struct
+{
+    int *items;
+    int size;
+    int capacity;
+} Bucket;
+
+static void bucket_push(Bucket *b, int v)
+{
+    if (b->size == b->capacity)
+    {
+        b->capacity = b->capacity ? b->capacity * 2 : 16;
+        b->items = realloc(b->items, b->capacity * sizeof(int));
+    }
+    b->items[b->size++] = v;
+}
+
+typedef struct DeltaStepping DeltaStepping;
+
+typedef struct
+{
+    DeltaStepping *ds;
+    int id;
+    Bucket *bins;   // baldes locais, indexados de forma circular
+    Bucket settled; // vértices do balde atual, para a fase de arestas pesadas
+} DeltaWorker;
+
+struct DeltaStepping
+{
+    Graph *g;
+    int *dist;
+    int *bucket_of; // último balde em que o vértice entrou em settled
+    int delta;
+    int num_bins;
+    int nthreads;
+    int *frontier;
+    int frontier_capacity;
+    int *counts;
+    int *next_bin;
+    DeltaWorker *workers;
+    pthread_barrier_t barrier;
+};
+
+// Relaxamento concorrente: grava value em *addr se for menor (min atômico)
+static int atomic_min(int *addr, int value)
+{
+    int atual = __atomic_load_n(addr, __ATOMIC_RELAXED);
+    while (value < atual)
+    {
+        if (__atomic_compare_exchange_n(addr, &atual, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            return 1;
+    }
+    return 0;
+}
+
+static void delta_relax(DeltaWorker *w, int u, int du, int heavy)
+{
+    DeltaStepping *ds = w->ds;
+    AdjList *list = &ds->g->vertices[u];
+    for (int i = 0; i < list->edge_count; i++)
+    {
+        int weight = list->edges[i].weight;
+        if ((weight > ds->delta) != heavy)
+            continue;
+        int v = list->edges[i].dest;
+        int nd = du + weight;
+        if (atomic_min(&ds->dist[v], nd))
+            bucket_push(&w->bins[(nd / ds->delta) % ds->num_bins], v);
+    }
+}
+
+static void *delta_worker(void *arg)
+{
+    DeltaWorker *w = arg;
+    DeltaStepping *ds = w->ds;
+    int curr = 0;
+
+    while (1)
+    {
+        // Fase leve: repete até o balde atual ficar vazio em todas as threads
+        while (1)
+        {
+            Bucket *b = &w->bins[curr % ds->num_bins];
+            ds->counts[w->id] = b->size;
+            pthread_barrier_wait(&ds->barrier);
+
+            int offset = 0, total = 0;
+            for (int t = 0; t < ds->nthreads; t++)
+            {
+                if (t < w->id)
+                    offset += ds->counts[t];
+                total += ds->counts[t];
+            }
+            if (total == 0)
+                break;
+            if (w->id == 0 && total > ds->frontier_capacity)
+            {
+                ds->frontier_capacity = total * 2;
+                ds->frontier = realloc(ds->frontier, ds->frontier_capacity * sizeof(int));
+            }
+            pthread_barrier_wait(&ds->barrier);
+            if (b->size > 0)
+                memcpy(ds->frontier + offset, b->items, b->size * sizeof(int));
+            b->size = 0;
+            pthread_barrier_wait(&ds->barrier);
+
+            int inicio = (int)((long long)total * w->id / ds->nthreads);
+            int fim = (int)((long long)total * (w->id + 1) / ds->nthreads);
+            for (int i = inicio; i < fim; i++)
+            {
+                int u = ds->frontier[i];
+                int du = __atomic_load_n(&ds->dist[u], __ATOMIC_RELAXED);
+                if (du / ds->delta != curr)
+                    continue; // entrada obsoleta: u já melhorou para um balde anterior
+                int marca = __atomic_load_n(&ds->bucket_of[u], __ATOMIC_RELAXED);
+                if (marca != curr && __atomic_compare_exchange_n(&ds->bucket_of[u], &marca, curr, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    bucket_push(&w->settled, u);
+                delta_relax(w, u, du, 0);
+            }
+        }
+
+        // Fase pesada: cada vértice do balde relaxa suas arestas pesadas uma única vez
+        for (int i = 0; i < w->settled.size; i++)
+        {
+            int u = w->settled.items[i];
+            delta_relax(w, u, __atomic_load_n(&ds->dist[u], __ATOMIC_RELAXED), 1);
+        }
+        w->settled.size = 0;
+        pthread_barrier_wait(&ds->barrier);
+
+        int proximo = -1;
+        for (int k = 1; k < ds->num_bins; k++)
+        {
+            if (w->bins[(curr + k) % ds->num_bins].size > 0)
+            {
+                proximo = curr + k;
+                break;
+            }
+        }
+        ds->next_bin[w->id] = proximo;
+        pthread_barrier_wait(&ds->barrier);
+
+        proximo = -1;
+        for (int t = 0; t < ds->nthreads; t++)
+            if (ds->next_bin[t] >= 0 && (proximo < 0 || ds->next_bin[t] < proximo))
+                proximo = ds->next_bin[t];
+        if (proximo < 0)
+            break;
+        curr = proximo;
+    }
+    return NULL;
+}
+
+// SSSP paralelo por Δ-stepping (Meyer & Sanders). delta <= 0 escolhe Δ
+// automaticamente e nthreads <= 0 usa todos os núcleos disponíveis.
+// Retorna o mesmo vetor de distâncias que dijkstra().
+int *delta_stepping(Graph *g, int start, int delta, int nthreads)
+{
+    int n = g->n;
+    DeltaStepping ds;
+    ds.g = g;
+    ds.delta = delta > 0 ? delta : escolher_delta(g);
+    ds.nthreads = nthreads > 0 ? nthreads : numero_de_threads();
+    // Distâncias provisórias ficam sempre em [curr·Δ, curr·Δ + peso máximo]
+    ds.num_bins = g->max_weight / ds.delta + 2;
+    ds.dist = malloc(n * sizeof(int));
+    ds.bucket_of = malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++)
+    {
+        ds.dist[i] = INF;
+        ds.bucket_of[i] = -1;
+    }
+    ds.frontier_capacity = 0;
+    ds.frontier = NULL;
+    ds.counts = calloc(ds.nthreads, sizeof(int));
+    ds.next_bin = calloc(ds.nthreads, sizeof(int));
+    ds.workers = calloc(ds.nthreads, sizeof(DeltaWorker));
+    for (int t = 0; t < ds.nthreads; t++)
+    {
+        ds.workers[t].ds = &ds;
+        ds.workers[t].id = t;
+        ds.workers[t].bins = calloc(ds.num_bins, sizeof(Bucket));
+    }
+    pthread_barrier_init(&ds.barrier, NULL, ds.nthreads);
+
+    ds.dist[start] = 0;
+    bucket_push(&ds.workers[0].bins[0], start);
+
+    pthread_t *threads = malloc(ds.nthreads * sizeof(pthread_t));
+    for (int t = 1; t < ds.nthreads; t++)
+        pthread_create(&threads[t], NULL, delta_worker, &ds.workers[t]);
+    delta_worker(&ds.workers[0]);
+    for (int t = 1; t < ds.nthreads; t++)
+        pthread_join(threads[t], NULL);
+
+    pthread_barrier_destroy(&ds.barrier);
+    for (int t = 0; t < ds.nthreads; t++)
+    {
+        for (int k = 0; k < ds.num_bins; k++)
+            free(ds.workers[t].bins[k].items);
+        free(ds.workers[t].bins);
+        free(ds.workers[t].settled.items);
+    }
+    free(threads);
+    free(ds.workers);
+    free(ds.next_bin);
+    free(ds.counts);
+    free(ds.frontier);
+    free(ds.bucket_of);
+    return ds.dist;
+}
+
+// Relógio monotônico em segundos (para medir etapas fora do laço de repetições)
+double tempo_atual()
+{
+#ifdef __linux__
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+#else
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + t.tv_usec / 1e6;
+#endif
+}
+
+// Uso de memória do processo numa fase do benchmark (carga, construção, busca).
+// O pico de RSS é o da fase: no início dela o marcador de pico do kernel é
+// zerado (escrevendo 5 em /proc/self/clear_refs) e no fim VmHWM é lido de
+// /proc/self/status. Sem esse recurso, guarda-se a variação de RSS na fase
+// (pico_da_fase = 0).
+typedef struct
+{
+    long pico_rss_kb;    // pico de RSS na fase, ou variação de RSS (ver pico_da_fase)
+    int pico_da_fase;
+    long falhas_menores; // falhas de página durante a fase
+    long falhas_maiores;
+} MedidaFase;
+
+typedef struct
+{
+    struct rusage uso;
+    long rss_kb;      // RSS no início da fase
+    int pico_zerado;  // o marcador de pico foi zerado no início da fase
+} InicioFase;
+
+// Lê um campo em kB de /proc/self/status (VmRSS, VmHWM); -1 se não houver
+static long ler_status_kb(const char *campo)
+{
+    long kb = -1;
+#ifdef __linux__
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f)
+        return -1;
+    char linha[256];
+    size_t tam = strlen(campo);
+    while (fgets(linha, sizeof(linha), f))
+        if (strncmp(linha, campo, tam) == 0 && linha[tam] == ':')
+        {
+            sscanf(linha + tam + 1, "%ld", &kb);
+            break;
+        }
+    fclose(f);
+#else
+    (void)campo;
+#endif
+    return kb;
+}
+
+static int zerar_pico_rss()
+{
+#ifdef __linux__
+    FILE *f = fopen("/proc/self/clear_refs", "w");
+    if (!f)
+        return 0;
+    int ok = fputs("5", f) >= 0;
+    return fclose(f) == 0 && ok;
+#else
+    return 0;
+#endif
+}
+
+void iniciar_fase(InicioFase *antes)
+{
+    antes->pico_zerado = zerar_pico_rss() && ler_status_kb("VmHWM") >= 0;
+    antes->rss_kb = ler_status_kb("VmRSS");
+    getrusage(RUSAGE_SELF, &antes->uso);
+}
+
+void encerrar_fase(const InicioFase *antes, MedidaFase *fase)
+{
+    struct rusage depois;
+    getrusage(RUSAGE_SELF, &depois);
+    fase->pico_da_fase = antes->pico_zerado;
+    if (antes->pico_zerado)
+        fase->pico_rss_kb = ler_status_kb("VmHWM");
+    else if (antes->rss_kb >= 0)
+        fase->pico_rss_kb = ler_status_kb("VmRSS") - antes->rss_kb;
+    else
+        fase->pico_rss_kb = depois.ru_maxrss - antes->uso.ru_maxrss; // quanto o pico do processo subiu
+    fase->falhas_menores = depois.ru_minflt - antes->uso.ru_minflt;
+    fase->falhas_maiores = depois.ru_majflt - antes->uso.ru_majflt;
+}
+
+// Contador de falhas de leitura na cache de último nível (LLC) da thread
+// atual, via perf_event_open, começando parado. Retorna -1 se não houver
+// contador de hardware (máquina virtual, perf_event_paranoid etc.).
+int abrir_contador_llc()
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd < 0)
+    {
+        // Sem o evento específico de LLC: falhas de cache genéricas
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+void ligar_contador(int fd, int ligado)
+{
+#ifdef __linux__
+    if (fd >= 0)
+        ioctl(fd, ligado ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+#endif
+}
+
+long long ler_contador(int fd)
+{
+    long long valor = 0;
+    if (fd < 0 || read(fd, &valor, sizeof(valor)) != sizeof(valor))
+        return -1;
+    return valor;
+}
+
+double mean(double *arr, int n)
+{
+    double s = 0;
+    for (int i = 0; i < n; i++)
+        s += arr[i];
+    return s / n;
+}
+
+double stddev(double *arr, int n, double m)
+{
+    double s = 0;
+    for (int i = 0; i < n; i++)
+        s += (arr[i] - m) * (arr[i] - m);
+    return sqrt(s / n);
+}
+
+// Arquivos comprimidos com gzip começam com 1f 8b
+static int eh_gzip(const void *dados, size_t tamanho)
+{
+    const unsigned char *b = dados;
+    return tamanho >= 2 && b[0] == 0x1f && b[1] == 0x8b;
+}
+
+#ifdef COM_ZLIB
+// Descomprime um gzip inteiro (um ou mais membros) para um buffer terminado
+// em '\0'. O tamanho original, guardado no fim do arquivo, serve de palpite.
+static char *descomprimir_gzip(const unsigned char *dados, size_t tamanho)
+{
+    size_t capacidade = tamanho * 4 + 1;
+    if (tamanho >= 18)
+    {
+        const unsigned char *t = dados + tamanho - 4;
+        size_t original = t[0] | t[1] << 8 | t[2] << 16 | (size_t)t[3] << 24;
+        if (original + 1 > capacidade)
+            capacidade = original + 1;
+    }
+    char *buf = memoria_malloc(capacidade, MEMORIA_JSON);
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    if (!buf || inflateInit2(&z, 15 + 16) != Z_OK)
+    {
+        memoria_free(buf);
+        return NULL;
+    }
+    size_t usados = 0;
+    int r = Z_OK;
+    z.next_in = (unsigned char *)dados;
+    while (1)
+    {
+        if (usados + 1 == capacidade)
+        {
+            char *maior = memoria_malloc(capacidade * 2, MEMORIA_JSON);
+            memcpy(maior, buf, usados);
+            memoria_free(buf);
+            buf = maior;
+            capacidade *= 2;
+        }
+        size_t resta = dados + tamanho - z.next_in;
+        z.avail_in = resta > UINT_MAX ? UINT_MAX : (unsigned)resta;
+        size_t livre = capacidade - 1 - usados;
+        z.next_out = (unsigned char *)buf + usados;
+        z.avail_out = livre > UINT_MAX ? UINT_MAX : (unsigned)livre;
+        unsigned antes = z.avail_out;
+        r = inflate(&z, Z_NO_FLUSH);
+        usados += antes - z.avail_out;
+        if (r == Z_STREAM_END)
+        {
+            // Membros concatenados (ex.: cat a.gz b.gz)
+            if (z.next_in == dados + tamanho || !eh_gzip(z.next_in, dados + tamanho - z.next_in))
+                break;
+            inflateReset(&z);
+        }
+        else if (r != Z_OK && !(r == Z_BUF_ERROR && z.avail_out == 0))
+            break;
+    }
+    inflateEnd(&z);
+    if (r != Z_STREAM_END)
+    {
+        memoria_free(buf);
+        return NULL;
+    }
+    buf[usados] = '\0';
+    return buf;
+}
+#endif
+
+// Lê o arquivo inteiro para um buffer terminado em '\0', descomprimindo se
+// for gzip
+char *read_file_to_buffer(const char *filename)
+{
+    FILE *f = fopen(filename, "rb");
+    if (!f)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    rewind(f);
+    char *buf = memoria_malloc(len + 1, MEMORIA_JSON);
+    if (!buf)
+    {
+        fclose(f);
+        return NULL;
+    }
+    fread(buf, 1, len, f);
+    buf[len] = '\0';
+    fclose(f);
+    if (eh_gzip(buf, len))
+    {
+#ifdef COM_ZLIB
+        char *texto = descomprimir_gzip((unsigned char *)buf, len);
+#else
+        fprintf(stderr, "%s está comprimido com gzip, mas o programa foi compilado sem zlib (-DCOM_ZLIB -lz)\n", filename);
+        char *texto = NULL;
+#endif
+        memoria_free(buf);
+        return texto;
+    }
+    return buf;
+}
+
+// Tabela de espalhamento id -> índice dos vértices (endereçamento aberto)
+typedef struct
+{
+    int *ids;
+    int *indices; // -1 marca posição vazia
+    unsigned mascara;
+} MapaIds;
+
+static unsigned espalhar_id(int id)
+{
+    return (unsigned)id * 2654435761u;
+}
+
+static void mapa_ids_init(MapaIds *mapa, int n)
+{
+    unsigned capacidade = 16;
+    while (capacidade < 2u * (unsigned)n)
+        capacidade *= 2;
+    mapa->ids = malloc(capacidade * sizeof(int));
+    mapa->indices = malloc(capacidade * sizeof(int));
+    memset(mapa->indices, -1, capacidade * sizeof(int));
+    mapa->mascara = capacidade - 1;
+}
+
+static void mapa_ids_free(MapaIds *mapa)
+{
+    free(mapa->ids);
+    free(mapa->indices);
+}
+
+// Ids repetidos mantêm o primeiro índice
+static void mapa_ids_inserir(MapaIds *mapa, int id, int idx)
+{
+    unsigned h = espalhar_id(id) & mapa->mascara;
+    while (mapa->indices[h] >= 0)
+    {
+        if (mapa->ids[h] == id)
+            return;
+        h = (h + 1) & mapa->mascara;
+    }
+    mapa->ids[h] = id;
+    mapa->indices[h] = idx;
+}
+
+static int id_to_index(const MapaIds *mapa, int id)
+{
+    unsigned h = espalhar_id(id) & mapa->mascara;
+    while (mapa->indices[h] >= 0)
+    {
+        if (mapa->ids[h] == id)
+            return mapa->indices[h];
+        h = (h + 1) & mapa->mascara;
+    }
+    return -1;
+}
+
+// Varredura estrutural mínima do JSON, só o bastante para achar e ler "links"
+static const char *pular_espacos(const char *p)
+{
+    while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
+        p++;
+    return p;
+}
+
+static const char *pular_string(const char *p)
+{
+    for (p++; *p != '"'; p++)
+    {
+        if (*p == '\0')
+            return NULL;
+        if (*p == '\\' && *++p == '\0')
+            return NULL;
+    }
+    return p + 1;
+}
+
+static const char *pular_valor(const char *p)
+{
+    if (*p == '"')
+        return pular_string(p);
+    if (*p != '{' && *p != '[')
+    {
+        while (*p && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t')
+            p++;
+        return p;
+    }
+    int profundidade = 0;
+    do
+    {
+        if (*p == '"')
+        {
+            p = pular_string(p);
+            if (!p)
+                return NULL;
+            continue;
+        }
+        if (*p == '{' || *p == '[')
+            profundidade++;
+        else if (*p == '}' || *p == ']')
+            profundidade--;
+        else if (*p == '\0')
+            return NULL;
+        p++;
+    } while (profundidade > 0);
+    return p;
+}
+
+// Localiza o conteúdo do vetor "links" no objeto raiz: [*inicio, *fim), com
+// *fim apontando para o ']'
+static int encontrar_links(const char *buffer, const char **inicio, const char **fim)
+{
+    const char *p = pular_espacos(buffer);
+    if (*p != '{')
+        return 0;
+    p = pular_espacos(p + 1);
+    while (*p == '"')
+    {
+        const char *chave = p + 1;
+        p = pular_string(p);
+        if (!p)
+            return 0;
+        int eh_links = p - chave == 6 && strncasecmp(chave, "links", 5) == 0;
+        p = pular_espacos(p);
+        if (*p != ':')
+            return 0;
+        p = pular_espacos(p + 1);
+        if (eh_links && *p == '[')
+        {
+            *inicio = p + 1;
+            const char *q = pular_valor(p);
+            if (!q)
+                return 0;
+            *fim = q - 1;
+            return 1;
+        }
+        p = pular_valor(p);
+        if (!p)
+            return 0;
+        p = pular_espacos(p);
+        if (*p != ',')
+            return 0;
+        p = pular_espacos(p + 1);
+    }
+    return 0;
+}
+
+// Número JSON como inteiro, truncando frações como o valueint do cJSON
+static const char *ler_inteiro_json(const char *p, int *valor, int *ok)
+{
+    char *fim;
+    long x = strtol(p, &fim, 10);
+    if (*fim == '.' || *fim == 'e' || *fim == 'E')
+    {
+        double d = strtod(p, &fim);
+        x = d >= INT_MAX ? INT_MAX : d <= INT_MIN ? INT_MIN : (long)d;
+    }
+    *ok = fim != p;
+    *valor = x > INT_MAX ? INT_MAX : x < INT_MIN ? INT_MIN : (int)x;
+    return *ok ? fim : pular_valor(p);
+}
+
+// Lê um objeto {"source": s, "target": t, "weight": w, ...}; *valido fica 0
+// se faltar origem ou destino numéricos. Como no cJSON_GetObjectItem, as
+// chaves ignoram maiúsculas e vale a primeira ocorrência.
+static const char *ler_link(const char *p, int *src, int *tgt, int *w, int *valido)
+{
+    int tem_src = 0, tem_tgt = 0, tem_peso = 0, ok;
+    *w = 1;
+    if (*p != '{')
+        return NULL;
+    p = pular_espacos(p + 1);
+    while (*p == '"')
+    {
+        const char *chave = p + 1;
+        p = pular_string(p);
+        if (!p)
+            return NULL;
+        size_t tam = p - 1 - chave;
+        p = pular_espacos(p);
+        if (*p != ':')
+            return NULL;
+        p = pular_espacos(p + 1);
+        if (tam == 6 && !tem_src && strncasecmp(chave, "source", 6) == 0)
+        {
+            p = ler_inteiro_json(p, src, &ok);
+            tem_src = ok ? 1 : -1;
+        }
+        else if (tam == 6 && !tem_tgt && strncasecmp(chave, "target", 6) == 0)
+        {
+            p = ler_inteiro_json(p, tgt, &ok);
+            tem_tgt = ok ? 1 : -1;
+        }
+        else if (tam == 6 && !tem_peso && strncasecmp(chave, "weight", 6) == 0)
+        {
+            int peso;
+            p = ler_inteiro_json(p, &peso, &ok);
+            if (ok)
+                *w = peso;
+            tem_peso = 1;
+        }
+        else
+            p = pular_valor(p);
+        if (!p)
+            return NULL;
+        p = pular_espacos(p);
+        if (*p == ',')
+            p = pular_espacos(p + 1);
+    }
+    if (*p != '}')
+        return NULL;
+    *valido = tem_src == 1 && tem_tgt == 1;
+    return p + 1;
+}
+
+// Pedaço do vetor "links" lido em paralelo. O corte em inicio é um palpite:
+// só vale se o pedaço anterior, lido a partir de uma fronteira verdadeira,
+// terminar exatamente ali.
+typedef struct
+{
+    const char *inicio;
+    const char *fim;
+    const char *parada; // onde a leitura parou (pode passar de fim)
+    ArcBuffer arcos;
+    int ok;
+} PedacoLinks;
+
+typedef struct
+{
+    PedacoLinks *pedacos;
+    int num_pedacos;
+    int proximo;
+    const MapaIds *mapa;
+} LeituraLinks;
+
+// Lê objetos a partir de p enquanto começarem antes de pedaco->fim; o último
+// pode terminar depois dele
+static void ler_pedaco_links(PedacoLinks *pedaco, const char *p, const MapaIds *mapa)
+{
+    pedaco->ok = 0;
+    while (p < pedaco->fim)
+    {
+        int src, tgt, w, valido;
+        p = ler_link(p, &src, &tgt, &w, &valido);
+        if (!p)
+            return;
+        int u = valido ? id_to_index(mapa, src) : -1;
+        int v = valido ? id_to_index(mapa, tgt) : -1;
+        if (u >= 0 && v >= 0)
+            arc_buffer_push(&pedaco->arcos, u, v, w);
+        p = pular_espacos(p);
+        if (*p == ',')
+            p = pular_espacos(p + 1);
+    }
+    pedaco->parada = p;
+    pedaco->ok = 1;
+}
+
+static void *ler_links_worker(void *arg)
+{
+    LeituraLinks *leitura = arg;
+    int k;
+    while ((k = __atomic_fetch_add(&leitura->proximo, 1, __ATOMIC_RELAXED)) < leitura->num_pedacos)
+        ler_pedaco_links(&leitura->pedacos[k], leitura->pedacos[k].inicio, leitura->mapa);
+    return NULL;
+}
+
+// Próximo ponto de corte a partir de p: o '{' de um "}, {\"" (com espaços)
+static const char *proximo_corte(const char *p, const char *fim)
+{
+    while (p < fim)
+    {
+        const char *fecha = memchr(p, '}', fim - p);
+        if (!fecha)
+            return fim;
+        const char *q = pular_espacos(fecha + 1);
+        if (*q == ',')
+        {
+            q = pular_espacos(q + 1);
+            if (q < fim && *q == '{' && *pular_espacos(q + 1) == '"')
+                return q;
+        }
+        p = fecha + 1;
+    }
+    return fim;
+}
+
+#define PEDACO_MINIMO (1 << 20)
+
+// Lê os arcos de [inicio, fim) em pedaços paralelos e depois confere os cortes
+// em ordem: um pedaço cujo início não coincide com a parada do anterior (corte
+// dentro de uma string ou de um objeto aninhado) é relido a partir da fronteira
+// verdadeira
+static int ler_links_paralelo(const char *inicio, const char *fim, const MapaIds *mapa, ArcBuffer **arcos, int *num_buffers)
+{
+    int nthreads = numero_de_threads();
+    long long bytes = fim - inicio;
+    int num_pedacos = nthreads > 1 ? nthreads * 4 : 1;
+    if (bytes / num_pedacos < PEDACO_MINIMO)
+        num_pedacos = (int)(bytes / PEDACO_MINIMO) > 1 ? (int)(bytes / PEDACO_MINIMO) : 1;
+
+    LeituraLinks leitura = {calloc(num_pedacos, sizeof(PedacoLinks)), 0, 0, mapa};
+    const char *p = pular_espacos(inicio);
+    for (int k = 0; k < num_pedacos && p < fim; k++)
+    {
+        const char *corte = k == num_pedacos - 1 ? fim : proximo_corte(inicio + bytes * (k + 1) / num_pedacos, fim);
+        if (corte <= p)
+            continue;
+        leitura.pedacos[leitura.num_pedacos].inicio = p;
+        leitura.pedacos[leitura.num_pedacos].fim = corte;
+        leitura.num_pedacos++;
+        p = corte;
+    }
+    if (nthreads > leitura.num_pedacos)
+        nthreads = leitura.num_pedacos;
+    pthread_t *threads = malloc((nthreads > 0 ? nthreads : 1) * sizeof(pthread_t));
+    for (int t = 1; t < nthreads; t++)
+        pthread_create(&threads[t], NULL, ler_links_worker, &leitura);
+    ler_links_worker(&leitura);
+    for (int t = 1; t < nthreads; t++)
+        pthread_join(threads[t], NULL);
+    free(threads);
+
+    int ok = 1;
+    p = pular_espacos(inicio);
+    for (int k = 0; k < leitura.num_pedacos && ok; k++)
+    {
+        PedacoLinks *pedaco = &leitura.pedacos[k];
+        if (pedaco->inicio != p)
+        {
+            arc_buffer_free(&pedaco->arcos);
+            if (p >= pedaco->fim)
+                continue; // engolido pelo último objeto do pedaço anterior
+            ler_pedaco_links(pedaco, p, mapa);
+        }
+        ok = pedaco->ok;
+        p = pedaco->parada;
+    }
+    ok = ok && p == fim;
+
+    *num_buffers = leitura.num_pedacos;
+    *arcos = malloc((leitura.num_pedacos > 0 ? leitura.num_pedacos : 1) * sizeof(ArcBuffer));
+    for (int k = 0; k < leitura.num_pedacos; k++)
+        (*arcos)[k] = leitura.pedacos[k].arcos;
+    free(leitura.pedacos);
+    return ok;
+}
+
+// Carrega grafo no formato node-link do NetworkX. O cabeçalho e os nós passam
+// pelo cJSON; o vetor "links", que domina o arquivo, é lido em paralelo.
+int load_graph_from_json(const char *filename, Graph *g)
+{
+    char *buffer = read_file_to_buffer(filename);
+    if (!buffer)
+        return 0;
+    const char *inicio_links, *fim_links;
+    if (!encontrar_links(buffer, &inicio_links, &fim_links))
+    {
+        memoria_free(buffer);
+        return 0;
+    }
+    // Cópia do documento com "links": [] para o cJSON
+    size_t antes = inicio_links - buffer, depois = strlen(fim_links);
+    char *cabecalho = memoria_malloc(antes + depois + 1, MEMORIA_JSON);
+    memcpy(cabecalho, buffer, antes);
+    memcpy(cabecalho + antes, fim_links, depois + 1);
+    cJSON *root = cJSON_Parse(cabecalho);
+    memoria_free(cabecalho);
+    if (!root)
+    {
+        memoria_free(buffer);
+        return 0;
+    }
+
+    int directed = 1;
+    cJSON *directed_item = cJSON_GetObjectItem(root, "directed");
+    if (directed_item && cJSON_IsBool(directed_item))
+        directed = cJSON_IsTrue(directed_item);
+    else if (directed_item && cJSON_IsNumber(directed_item))
+        directed = directed_item->valueint;
+
+    cJSON *nodes = cJSON_GetObjectItem(root, "nodes");
+    if (!cJSON_IsArray(nodes))
+    {
+        cJSON_Delete(root);
+        memoria_free(buffer);
+        return 0;
+    }
+    int n = cJSON_GetArraySize(nodes);
+    MapaIds mapa;
+    mapa_ids_init(&mapa, n);
+    int i = 0;
+    cJSON *node;
+    cJSON_ArrayForEach(node, nodes)
+    {
+        cJSON *id = cJSON_GetObjectItem(node, "id");
+        if (id && cJSON_IsNumber(id))
+            mapa_ids_inserir(&mapa, id->valueint, i);
+        i++;
+    }
+    cJSON_Delete(root);
+
+    ArcBuffer *arcos;
+    int num_buffers;
+    int ok = ler_links_paralelo(inicio_links, fim_links, &mapa, &arcos, &num_buffers);
+    memoria_free(buffer);
+    mapa_ids_free(&mapa);
+    if (ok)
+    {
+        init_graph(g, n);
+        g->directed = directed;
+        build_graph_from_arcs(g, arcos, num_buffers, !directed, 1);
+        compute_components(g);
+    }
+    for (int k = 0; k < num_buffers; k++)
+        arc_buffer_free(&arcos[k]);
+    free(arcos);
+    return ok;
+}
+
+// Arquivo de entrada mapeado em memória, só para leitura (fora do Linux, lido
+// para um buffer). Os dados não terminam em '\0': use sempre tamanho.
+typedef struct
+{
+    const char *dados;
+    size_t tamanho;
+    int mapeado;
+} ArquivoMapeado;
+
+static int mapear_arquivo(const char *filename, ArquivoMapeado *a)
+{
+    a->mapeado = 0;
+#ifdef __linux__
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        close(fd);
+        return 0;
+    }
+    a->tamanho = st.st_size;
+    a->dados = "";
+    if (a->tamanho > 0)
+    {
+        void *p = mmap(NULL, a->tamanho, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            close(fd);
+            return 0;
+        }
+        madvise(p, a->tamanho, MADV_SEQUENTIAL);
+        madvise(p, a->tamanho, MADV_WILLNEED);
+        a->dados = p;
+        a->mapeado = 1;
+    }
+    close(fd);
+    return 1;
+#else
+    char *buf = read_file_to_buffer(filename);
+    if (!buf)
+        return 0;
+    a->dados = buf;
+    a->tamanho = strlen(buf);
+    return 1;
+#endif
+}
+
+static void desmapear_arquivo(ArquivoMapeado *a)
+{
+#ifdef __linux__
+    if (a->mapeado)
+        munmap((void *)a->dados, a->tamanho);
+#else
+    memoria_free((char *)a->dados);
+#endif
+}
+
+// Formatos de texto com um registro por linha
+enum
+{
+    FORMATO_DIMACS, // "p sp n m", depois "a u v w" (vértices a partir de 1)
+    FORMATO_LISTA,  // "u v [w]" (vértices a partir de 0, peso 1 se omitido)
+    FORMATO_METIS   // "n m [fmt [ncon]]", depois a linha i lista os vizinhos de i
+};
+
+// Inteiro decimal em [p, fim), depois de espaços e tabulações (não atravessa
+// a quebra de linha). Retorna 1 se leu, 0 no fim da linha e -1 em caractere
+// inválido ou estouro.
+static int ler_inteiro_texto(const char **p, const char *fim, long long *valor)
+{
+    const char *q = *p;
+    while (q < fim && (*q == ' ' || *q == '\t' || *q == '\r'))
+        q++;
+    *p = q;
+    if (q == fim || *q == '\n')
+        return 0;
+    int negativo = *q == '-';
+    if (*q == '-' || *q == '+')
+        q++;
+    if (q == fim || (unsigned)(*q - '0') > 9)
+        return -1;
+    long long v = 0;
+    while (q < fim && (unsigned)(*q - '0') <= 9)
+    {
+        v = v * 10 + (*q++ - '0');
+        if (v > INT_MAX)
+            return -1;
+    }
+    if (q < fim && *q != ' ' && *q != '\t' && *q != '\r' && *q != '\n')
+        return -1;
+    *valor = negativo ? -v : v;
+    *p = q;
+    return 1;
+}
+
+static const char *proxima_linha(const char *p, const char *fim)
+{
+    const char *nl = memchr(p, '\n', fim - p);
+    return nl ? nl + 1 : fim;
+}
+
+// Lê uma linha de dados que deve ter exatamente k inteiros
+static int ler_campos(const char **p, const char *fim, long long *campos, int k)
+{
+    for (int i = 0; i < k; i++)
+        if (ler_inteiro_texto(p, fim, &campos[i]) != 1)
+            return 0;
+    long long resto;
+    return ler_inteiro_texto(p, fim, &resto) == 0;
+}
+
+typedef struct
+{
+    int formato;
+    int n;            // vértices declarados no cabeçalho (DIMACS, METIS)
+    int pesos_arestas; // METIS: pares vizinho/peso
+    int campos_vertice; // METIS: tamanho e pesos do vértice a ignorar no início da linha
+} FormatoTexto;
+
+// Pedaço de linhas inteiras [inicio, fim) lido por uma thread. No METIS o
+// vértice de cada linha só é conhecido depois de somar as linhas dos pedaços
+// anteriores, então os arcos saem com a origem local ao pedaço.
+typedef struct
+{
+    const char *inicio;
+    const char *fim;
+    ArcBuffer arcos;
+    int linhas;   // linhas de dados (METIS)
+    int maior_id; // maior vértice visto (lista de arestas)
+    int ok;
+} PedacoTexto;
+
+typedef struct
+{
+    PedacoTexto *pedacos;
+    int num_pedacos;
+    int proximo;
+    const FormatoTexto *formato;
+} LeituraTexto;
+
+static int ler_linha_texto(PedacoTexto *pedaco, const FormatoTexto *f, const char *p, const char *fim)
+{
+    long long c[3];
+    if (f->formato == FORMATO_DIMACS)
+    {
+        while (p < fim && (*p == ' ' || *p == '\t' || *p == '\r'))
+            p++;
+        if (p == fim || *p == '\n' || *p == 'c')
+            return 1;
+        if (*p != 'a')
+            return 0;
+        p++;
+        if (!ler_campos(&p, fim, c, 3))
+            return 0;
+        if (c[0] < 1 || c[0] > f->n || c[1] < 1 || c[1] > f->n || c[2] < 0)
+            return 0;
+        arc_buffer_push(&pedaco->arcos, (int)c[0] - 1, (int)c[1] - 1, (int)c[2]);
+        return 1;
+    }
+    if (f->formato == FORMATO_LISTA)
+    {
+        const char *q = p;
+        while (q < fim && (*q == ' ' || *q == '\t' || *q == '\r'))
+            q++;
+        if (q == fim || *q == '\n' || *q == '#' || *q == '%')
+            return 1;
+        int lidos = 0, r;
+        while (lidos < 3 && (r = ler_inteiro_texto(&q, fim, &c[lidos])) == 1)
+            lidos++;
+        if (lidos < 2 || (lidos == 3 && ler_inteiro_texto(&q, fim, &c[0]) != 0) || (lidos == 2 && r != 0))
+            return 0;
+        if (c[0] < 0 || c[1] < 0 || (lidos == 3 && c[2] < 0))
+            return 0;
+        arc_buffer_push(&pedaco->arcos, (int)c[0], (int)c[1], lidos == 3 ? (int)c[2] : 1);
+        if (c[0] > pedaco->maior_id)
+            pedaco->maior_id = (int)c[0];
+        if (c[1] > pedaco->maior_id)
+            pedaco->maior_id = (int)c[1];
+        return 1;
+    }
+    // METIS: até linha vazia é um vértice (sem vizinhos); só '%' é comentário
+    if (p < fim && *p == '%')
+        return 1;
+    int u = pedaco->linhas++;
+    for (int i = 0; i < f->campos_vertice; i++)
+        if (ler_inteiro_texto(&p, fim, &c[0]) != 1)
+            return 0;
+    int r;
+    while ((r = ler_inteiro_texto(&p, fim, &c[0])) == 1)
+    {
+        c[1] = 1;
+        if (f->pesos_arestas && ler_inteiro_texto(&p, fim, &c[1]) != 1)
+            return 0;
+        if (c[0] < 1 || c[0] > f->n || c[1] < 0)
+            return 0;
+        arc_buffer_push(&pedaco->arcos, u, (int)c[0] - 1, (int)c[1]);
+    }
+    return r == 0;
+}
+
+static void ler_pedaco_texto(PedacoTexto *pedaco, const FormatoTexto *f)
+{
+    pedaco->ok = 1;
+    pedaco->maior_id = -1;
+    for (const char *p = pedaco->inicio; p < pedaco->fim && pedaco->ok;)
+    {
+        const char *q = proxima_linha(p, pedaco->fim);
+        pedaco->ok = ler_linha_texto(pedaco, f, p, q);
+        p = q;
+    }
+}
+
+static void *ler_texto_worker(void *arg)
+{
+    LeituraTexto *leitura = arg;
+    int k;
+    while ((k = __atomic_fetch_add(&leitura->proximo, 1, __ATOMIC_RELAXED)) < leitura->num_pedacos)
+        ler_pedaco_texto(&leitura->pedacos[k], leitura->formato);
+    return NULL;
+}
+
+// Lê as linhas de [inicio, fim) em pedaços paralelos cortados em quebras de
+// linha; devolve um ArcBuffer por pedaço e os totais de linhas e maior vértice
+static int ler_texto_paralelo(const char *inicio, const char *fim, const FormatoTexto *f, ArcBuffer **arcos, int *num_buffers, int *linhas, int *maior_id)
+{
+    int nthreads = numero_de_threads();
+    long long bytes = fim - inicio;
+    int num_pedacos = nthreads > 1 ? nthreads * 4 : 1;
+    if (bytes / num_pedacos < PEDACO_MINIMO)
+        num_pedacos = (int)(bytes / PEDACO_MINIMO) > 1 ? (int)(bytes / PEDACO_MINIMO) : 1;
+
+    LeituraTexto leitura = {calloc(num_pedacos, sizeof(PedacoTexto)), 0, 0, f};
+    const char *p = inicio;
+    for (int k = 0; k < num_pedacos && p < fim; k++)
+    {
+        const char *corte = k == num_pedacos - 1 ? fim : inicio + bytes * (k + 1) / num_pedacos;
+        if (corte <= p)
+            continue;
+        corte = proxima_linha(corte - 1, fim);
+        leitura.pedacos[leitura.num_pedacos].inicio = p;
+        leitura.pedacos[leitura.num_pedacos].fim = corte;
+        leitura.num_pedacos++;
+        p = corte;
+    }
+    if (nthreads > leitura.num_pedacos)
+        nthreads = leitura.num_pedacos;
+    pthread_t *threads = malloc((nthreads > 0 ? nthreads : 1) * sizeof(pthread_t));
+    for (int t = 1; t < nthreads; t++)
+        pthread_create(&threads[t], NULL, ler_texto_worker, &leitura);
+    ler_texto_worker(&leitura);
+    for (int t = 1; t < nthreads; t++)
+        pthread_join(threads[t], NULL);
+    free(threads);
+
+    int ok = 1;
+    *linhas = 0;
+    *maior_id = -1;
+    *num_buffers = leitura.num_pedacos;
+    *arcos = malloc((leitura.num_pedacos > 0 ? leitura.num_pedacos : 1) * sizeof(ArcBuffer));
+    for (int k = 0; k < leitura.num_pedacos; k++)
+    {
+        PedacoTexto *pedaco = &leitura.pedacos[k];
+        ok = ok && pedaco->ok;
+        if (f->formato == FORMATO_METIS)
+            for (int i = 0; i < pedaco->arcos.count; i++)
+                pedaco->arcos.arcs[i].u += *linhas;
+        *linhas += pedaco->linhas;
+        if (pedaco->maior_id > *maior_id)
+            *maior_id = pedaco->maior_id;
+        (*arcos)[k] = pedaco->arcos;
+    }
+    free(leitura.pedacos);
+    return ok;
+}
+
+// Cabeçalho do DIMACS ("p sp n m") ou do METIS ("n m [fmt [ncon]]"), depois
+// dos comentários; retorna o início das linhas de dados ou NULL
+static const char *ler_cabecalho_texto(const char *p, const char *fim, FormatoTexto *f)
+{
+    long long c[4];
+    while (p < fim)
+    {
+        const char *q = proxima_linha(p, fim);
+        const char *r = p;
+        while (r < q && (*r == ' ' || *r == '\t' || *r == '\r'))
+            r++;
+        if (f->formato == FORMATO_DIMACS)
+        {
+            if (r < q && *r == 'p')
+            {
+                r++;
+                while (r < q && (*r == ' ' || *r == '\t'))
+                    r++;
+                if (q - r < 2 || strncmp(r, "sp", 2) != 0)
+                    return NULL;
+                r += 2;
+                if (!ler_campos(&r, q, c, 2) || c[0] < 1)
+                    return NULL;
+                f->n = (int)c[0];
+                return q;
+            }
+            if (r < q && *r != 'c' && *r != '\n')
+                return NULL;
+        }
+        else if (r < q && *r != '%' && *r != '\n')
+        {
+            int lidos = 0, k;
+            while (lidos < 4 && (k = ler_inteiro_texto(&r, q, &c[lidos])) == 1)
+                lidos++;
+            if (lidos < 2 || c[0] < 1)
+                return NULL;
+            int fmt = lidos > 2 ? (int)c[2] : 0;
+            int ncon = lidos > 3 ? (int)c[3] : 1;
+            f->n = (int)c[0];
+            f->pesos_arestas = fmt % 10 == 1;
+            f->campos_vertice = (fmt / 100 % 10 == 1) + (fmt / 10 % 10 == 1 ? ncon : 0);
+            return q;
+        }
+        p = q;
+    }
+    return NULL;
+}
+
+// Arcos reunidos de vários trechos lidos em sequência (blocos do gzip); no
+// METIS a origem de cada arco é deslocada pelas linhas dos trechos anteriores
+typedef struct
+{
+    ArcBuffer *arcos;
+    int num_buffers;
+    int capacidade;
+    int linhas;
+    int maior_id;
+} ArcosLidos;
+
+static void juntar_arcos(ArcosLidos *t, ArcBuffer *arcos, int num_buffers, int linhas, int maior_id, int metis)
+{
+    if (t->num_buffers + num_buffers > t->capacidade)
+    {
+        t->capacidade = (t->num_buffers + num_buffers) * 2;
+        t->arcos = realloc(t->arcos, t->capacidade * sizeof(ArcBuffer));
+    }
+    for (int k = 0; k < num_buffers; k++)
+    {
+        if (metis)
+            for (int i = 0; i < arcos[k].count; i++)
+                arcos[k].arcs[i].u += t->linhas;
+        t->arcos[t->num_buffers++] = arcos[k];
+    }
+    t->linhas += linhas;
+    if (maior_id > t->maior_id)
+        t->maior_id = maior_id;
+    free(arcos);
+}
+
+// Lê o trecho [p, fim) e junta os arcos; o primeiro trecho traz o cabeçalho
+static int ler_trecho_texto(const char *p, const char *fim, int primeiro, FormatoTexto *f, ArcosLidos *lidos)
+{
+    if (primeiro && f->formato != FORMATO_LISTA)
+        p = ler_cabecalho_texto(p, fim, f);
+    if (!p)
+        return 0;
+    ArcBuffer *arcos;
+    int num_buffers, linhas, maior_id;
+    int ok = ler_texto_paralelo(p, fim, f, &arcos, &num_buffers, &linhas, &maior_id);
+    juntar_arcos(lidos, arcos, num_buffers, linhas, maior_id, f->formato == FORMATO_METIS);
+    return ok;
+}
+
+#ifdef COM_ZLIB
+// Texto comprimido lido em fluxo: uma thread descomprime em blocos que terminam
+// numa quebra de linha, num anel de BLOCOS_GZIP posições, enquanto a thread da
+// carga lê o bloco anterior. O texto descomprimido nunca fica inteiro na memória.
+#define BLOCO_GZIP (4 << 20)
+#define BLOCOS_GZIP 3
+
+typedef struct
+{
+    const unsigned char *entrada;
+    size_t tamanho;
+    char *blocos[BLOCOS_GZIP];
+    size_t capacidades[BLOCOS_GZIP];
+    size_t usados[BLOCOS_GZIP];
+    int produzidos; // blocos prontos; o bloco k fica em blocos[k % BLOCOS_GZIP]
+    int consumidos;
+    int terminou;
+    int erro;     // gzip corrompido ou truncado
+    int cancelar; // a leitura desistiu (linha inválida)
+    pthread_mutex_t lock;
+    pthread_cond_t pronto;
+    pthread_cond_t livre;
+} FluxoGzip;
+
+static size_t ultima_quebra(const char *b, size_t n)
+{
+    while (n > 0 && b[n - 1] != '\n')
+        n--;
+    return n;
+}
+
+static void crescer_bloco(char **bloco, size_t *capacidade, size_t usados, size_t minimo)
+{
+    if (*capacidade >= minimo)
+        return;
+    char *maior = memoria_malloc(minimo, MEMORIA_JSON);
+    if (usados)
+        memcpy(maior, *bloco, usados);
+    memoria_free(*bloco);
+    *bloco = maior;
+    *capacidade = minimo;
+}
+
+static void *descomprimir_fluxo(void *arg)
+{
+    FluxoGzip *fl = arg;
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    int erro = inflateInit2(&z, 15 + 16) != Z_OK, acabou = 0;
+    z.next_in = (unsigned char *)fl->entrada;
+    const unsigned char *fim_entrada = fl->entrada + fl->tamanho;
+    char *resto = NULL; // linha incompleta do fim do bloco anterior
+    size_t tam_resto = 0, cap_resto = 0;
+    for (int k = 0; !acabou && !erro; k++)
+    {
+        pthread_mutex_lock(&fl->lock);
+        while (k - fl->consumidos >= BLOCOS_GZIP && !fl->cancelar)
+            pthread_cond_wait(&fl->livre, &fl->lock);
+        int cancelar = fl->cancelar;
+        pthread_mutex_unlock(&fl->lock);
+        if (cancelar)
+            break;
+
+        int s = k % BLOCOS_GZIP;
+        crescer_bloco(&fl->blocos[s], &fl->capacidades[s], 0, tam_resto + BLOCO_GZIP);
+        if (tam_resto)
+            memcpy(fl->blocos[s], resto, tam_resto);
+        size_t usados = tam_resto;
+        while (1)
+        {
+            if (usados == fl->capacidades[s])
+            {
+                if (ultima_quebra(fl->blocos[s], usados) > 0)
+                    break;
+                // Linha maior que o bloco (lista METIS de um hub): dobra o bloco
+                crescer_bloco(&fl->blocos[s], &fl->capacidades[s], usados, usados * 2);
+            }
+            size_t resta = fim_entrada - z.next_in, livre = fl->capacidades[s] - usados;
+            z.avail_in = resta > UINT_MAX ? UINT_MAX : (unsigned)resta;
+            z.next_out = (unsigned char *)fl->blocos[s] + usados;
+            z.avail_out = livre > UINT_MAX ? UINT_MAX : (unsigned)livre;
+            unsigned antes = z.avail_out;
+            int r = inflate(&z, Z_NO_FLUSH);
+            usados += antes - z.avail_out;
+            if (r == Z_STREAM_END)
+            {
+                // Membros concatenados (ex.: cat a.gz b.gz)
+                if (z.next_in == fim_entrada || !eh_gzip(z.next_in, fim_entrada - z.next_in))
+                {
+                    acabou = 1;
+                    break;
+                }
+                inflateReset(&z);
+            }
+            else if (r != Z_OK && !(r == Z_BUF_ERROR && z.avail_out == 0))
+            {
+                erro = 1;
+                break;
+            }
+        }
+        if (erro)
+            break;
+        size_t corte = acabou ? usados : ultima_quebra(fl->blocos[s], usados);
+        tam_resto = usados - corte;
+        if (tam_resto > cap_resto)
+        {
+            cap_resto = tam_resto * 2;
+            resto = realloc(resto, cap_resto);
+        }
+        if (tam_resto)
+            memcpy(resto, fl->blocos[s] + corte, tam_resto);
+
+        pthread_mutex_lock(&fl->lock);
+        fl->usados[s] = corte;
+        fl->produzidos = k + 1;
+        pthread_cond_signal(&fl->pronto);
+        pthread_mutex_unlock(&fl->lock);
+    }
+    inflateEnd(&z);
+    free(resto);
+    pthread_mutex_lock(&fl->lock);
+    fl->terminou = 1;
+    fl->erro = erro;
+    pthread_cond_signal(&fl->pronto);
+    pthread_mutex_unlock(&fl->lock);
+    return NULL;
+}
+
+static int ler_texto_gzip(const ArquivoMapeado *arquivo, FormatoTexto *f, ArcosLidos *lidos)
+{
+    FluxoGzip fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.entrada = (const unsigned char *)arquivo->dados;
+    fl.tamanho = arquivo->tamanho;
+    pthread_mutex_init(&fl.lock, NULL);
+    pthread_cond_init(&fl.pronto, NULL);
+    pthread_cond_init(&fl.livre, NULL);
+    pthread_t produtor;
+    pthread_create(&produtor, NULL, descomprimir_fluxo, &fl);
+
+    int ok = 1, primeiro = 1;
+    while (ok)
+    {
+        pthread_mutex_lock(&fl.lock);
+        while (fl.produzidos == fl.consumidos && !fl.terminou)
+            pthread_cond_wait(&fl.pronto, &fl.lock);
+        int tem_bloco = fl.produzidos > fl.consumidos;
+        pthread_mutex_unlock(&fl.lock);
+        if (!tem_bloco)
+            break;
+
+        int s = fl.consumidos % BLOCOS_GZIP;
+        ok = ler_trecho_texto(fl.blocos[s], fl.blocos[s] + fl.usados[s], primeiro, f, lidos);
+        primeiro = 0;
+
+        pthread_mutex_lock(&fl.lock);
+        fl.consumidos++;
+        fl.cancelar = !ok;
+        pthread_cond_signal(&fl.livre);
+        pthread_mutex_unlock(&fl.lock);
+    }
+    pthread_join(produtor, NULL);
+    ok = ok && !fl.erro && !primeiro;
+
+    for (int s = 0; s < BLOCOS_GZIP; s++)
+        memoria_free(fl.blocos[s]);
+    pthread_cond_destroy(&fl.livre);
+    pthread_cond_destroy(&fl.pronto);
+    pthread_mutex_destroy(&fl.lock);
+    return ok;
+}
+#endif
+
+// Carrega grafo em DIMACS (.gr), lista de arestas ou METIS a partir do arquivo
+// mapeado em memória, lido em paralelo e montado por build_graph_from_arcs.
+// Arquivos gzip são descomprimidos em fluxo, sobrepostos à leitura.
+// DIMACS e listas de arestas são direcionados; no METIS cada aresta já aparece
+// nos dois sentidos e o grafo é não direcionado.
+int load_graph_from_text(const char *filename, int formato, Graph *g)
+{
+    ArquivoMapeado arquivo;
+    if (!mapear_arquivo(filename, &arquivo))
+        return 0;
+    FormatoTexto f = {formato, 0, 0, 0};
+    ArcosLidos lidos = {NULL, 0, 0, 0, -1};
+    int ok;
+    if (eh_gzip(arquivo.dados, arquivo.tamanho))
+    {
+#ifdef COM_ZLIB
+        ok = ler_texto_gzip(&arquivo, &f, &lidos);
+#else
+        fprintf(stderr, "%s está comprimido com gzip, mas o programa foi compilado sem zlib (-DCOM_ZLIB -lz)\n", filename);
+        ok = 0;
+#endif
+    }
+    else
+        ok = ler_trecho_texto(arquivo.dados, arquivo.dados + arquivo.tamanho, 1, &f, &lidos);
+    desmapear_arquivo(&arquivo);
+    int n = formato == FORMATO_LISTA ? lidos.maior_id + 1 : f.n;
+    // Sem vértices (só comentários, ou "p sp 0 0") não há grafo
+    if (n < 1)
+        ok = 0;
+    if (formato == FORMATO_METIS && lidos.linhas < n)
+        ok = 0;
+    for (int k = 0; k < lidos.num_buffers && ok && formato == FORMATO_METIS; k++)
+        for (int i = 0; i < lidos.arcos[k].count && ok; i++)
+            ok = lidos.arcos[k].arcs[i].u < n;
+    if (ok)
+    {
+        init_graph(g, n);
+        g->directed = formato != FORMATO_METIS;
+        build_graph_from_arcs(g, lidos.arcos, lidos.num_buffers, 0, 1);
+        compute_components(g);
+    }
+    for (int k = 0; k < lidos.num_buffers; k++)
+        arc_buffer_free(&lidos.arcos[k]);
+    free(lidos.arcos);
+    return ok;
+}
+
+static int termina_com(const char *s, const char *sufixo)
+{
+    size_t a = strlen(s), b = strlen(sufixo);
+    return a >= b && strcasecmp(s + a - b, sufixo) == 0;
+}
+
+// Escolhe o leitor pela extensão: .json (node-link), .gr (DIMACS),
+// .graph/.metis (METIS) e qualquer outra como lista de arestas. Um .gz no fim
+// é ignorado na escolha; o conteúdo gzip é reconhecido pelos leitores.
+static int carregar_por_extensao(const char *filename, Graph *g)
+{
+    char nome[256];
+    snprintf(nome, sizeof(nome), "%s", filename);
+    if (termina_com(nome, ".gz"))
+        nome[strlen(nome) - 3] = '\0';
+    if (termina_com(nome, ".json"))
+        return load_graph_from_json(filename, g);
+    if (termina_com(nome, ".gr"))
+        return load_graph_from_text(filename, FORMATO_DIMACS, g);
+    if (termina_com(nome, ".graph") || termina_com(nome, ".metis"))
+        return load_graph_from_text(filename, FORMATO_METIS, g);
+    return load_graph_from_text(filename, FORMATO_LISTA, g);
+}
+
+// Instantâneo binário do grafo montado, gravado ao lado do arquivo de origem
+// (<arquivo>.grafo.bin) na primeira carga. Vale enquanto tamanho e mtime da
+// origem forem os mesmos, ou, se só o mtime mudou, enquanto o hash do
+// conteúdo for o mesmo; senão é refeito na próxima carga. Layout:
+//   CabecalhoInstantaneo
+//   graus[n], e, se houver componentes, component[n],
+//   component_start[num_components + 1], component_vertices[n], local_index[n]
+//   (preenchimento até inicio_arestas, múltiplo de ALINHAMENTO_INSTANTANEO)
+//   64 bytes livres + Edge[arestas]
+// O trecho das arestas é mapeado direto (MAP_PRIVATE): os 64 bytes livres
+// recebem o CabecalhoBloco, de modo que o bloco vira o edge_pool e é
+// desmapeado por liberar() como qualquer outro.
+#define ALINHAMENTO_INSTANTANEO 65536
+#define VERSAO_INSTANTANEO 1
+
+typedef struct
+{
+    long long tamanho;
+    long long mtime_s;
+    long long mtime_ns;
+    unsigned long long hash;
+} ChaveFonte;
+
+typedef struct
+{
+    char magica[8];
+    int versao;
+    int directed;
+    ChaveFonte chave;
+    int n;
+    int num_components;
+    long long m;
+    long long arestas;
+    int min_weight;
+    int max_weight;
+    long long inicio_arestas;
+} CabecalhoInstantaneo;
+
+enum
+{
+    INSTANTANEO_NENHUM,
+    INSTANTANEO_LIDO,
+    INSTANTANEO_GRAVADO
+};
+
+int estado_instantaneo; // o que aconteceu com o instantâneo na última load_graph
+
+// DIJKSTRA_INSTANTANEO=desligado sempre relê a origem e não grava nada
+static int instantaneo_ligado()
+{
+    const char *valor = getenv("DIJKSTRA_INSTANTANEO");
+    return !(valor && strcmp(valor, "desligado") == 0);
+}
+
+// DIJKSTRA_INSTANTANEO=verificar confere o hash da origem mesmo quando
+// tamanho e mtime batem
+static int instantaneo_verificar()
+{
+    const char *valor = getenv("DIJKSTRA_INSTANTANEO");
+    return valor && strcmp(valor, "verificar") == 0;
+}
+
+// Hash de 64 bits do conteúdo, 32 bytes por passo em quatro acumuladores
+// independentes
+static unsigned long long hash_conteudo(const unsigned char *p, size_t n)
+{
+    const unsigned long long primo = 0x9e3779b97f4a7c15ull;
+    unsigned long long h[4] = {n, primo, primo * 3, primo * 5};
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+        for (int k = 0; k < 4; k++)
+        {
+            unsigned long long w;
+            memcpy(&w, p + i + 8 * k, 8);
+            h[k] = (h[k] ^ w) * 0xff51afd7ed558ccdull;
+            h[k] ^= h[k] >> 29;
+        }
+    unsigned long long r = h[0] ^ (h[1] << 1 | h[1] >> 63) ^ (h[2] << 2 | h[2] >> 62) ^ (h[3] << 3 | h[3] >> 61);
+    for (; i < n; i++)
+        r = (r ^ p[i]) * primo;
+    r ^= r >> 31;
+    return r * 0xc4ceb9fe1a85ec53ull;
+}
+
+#ifdef __linux__
+// Tamanho e mtime da origem; o hash só é calculado por hash_da_fonte, quando
+// preciso
+static int chave_da_fonte(const char *filename, ChaveFonte *c)
+{
+    struct stat st;
+    if (stat(filename, &st) < 0)
+        return 0;
+    c->tamanho = st.st_size;
+    c->mtime_s = st.st_mtim.tv_sec;
+    c->mtime_ns = st.st_mtim.tv_nsec;
+    c->hash = 0;
+    return 1;
+}
+
+static int hash_da_fonte(const char *filename, ChaveFonte *c)
+{
+    ArquivoMapeado arquivo;
+    if (!mapear_arquivo(filename, &arquivo))
+        return 0;
+    c->hash = hash_conteudo((const unsigned char *)arquivo.dados, arquivo.tamanho);
+    desmapear_arquivo(&arquivo);
+    return 1;
+}
+
+static long long inicio_das_arestas(const CabecalhoInstantaneo *cab)
+{
+    long long inteiros = cab->n + (cab->num_components > 0 ? 3LL * cab->n + cab->num_components + 1 : 0);
+    long long bytes = sizeof(CabecalhoInstantaneo) + inteiros * (long long)sizeof(int);
+    return (bytes + ALINHAMENTO_INSTANTANEO - 1) / ALINHAMENTO_INSTANTANEO * ALINHAMENTO_INSTANTANEO;
+}
+
+// Confere o conteúdo mapeado antes de adotá-lo: graus somando as arestas,
+// destinos e pesos válidos e, se houver, componentes coerentes entre si
+static int instantaneo_consistente(const CabecalhoInstantaneo *cab, const int *graus, const Edge *arestas)
+{
+    int n = cab->n, nc = cab->num_components;
+    long long soma = 0;
+    for (int u = 0; u < n; u++)
+    {
+        if (graus[u] < 0)
+            return 0;
+        soma += graus[u];
+    }
+    if (soma != cab->arestas)
+        return 0;
+    for (long long i = 0; i < cab->arestas; i++)
+        if ((unsigned)arestas[i].dest >= (unsigned)n || arestas[i].weight < 0)
+            return 0;
+    if (nc == 0)
+        return 1;
+    const int *component = graus + n;
+    const int *component_start = component + n;
+    const int *component_vertices = component_start + nc + 1;
+    const int *local_index = component_vertices + n;
+    if (component_start[0] != 0 || component_start[nc] != n)
+        return 0;
+    for (int c = 0; c < nc; c++)
+    {
+        if (component_start[c + 1] <= component_start[c])
+            return 0;
+        for (int i = component_start[c]; i < component_start[c + 1]; i++)
+        {
+            int v = component_vertices[i];
+            if ((unsigned)v >= (unsigned)n || component[v] != c || local_index[v] != i - component_start[c])
+                return 0;
+        }
+    }
+    return 1;
+}
+
+// Aceita o instantâneo se o tamanho da origem bate e o mtime também; com
+// mtime diferente (ou DIJKSTRA_INSTANTANEO=verificar), só se o hash do
+// conteúdo bater. O hash calculado fica em chave, e *com_hash marca isso.
+static int carregar_instantaneo(const char *nome, const char *fonte, ChaveFonte *chave, int *com_hash, Graph *g)
+{
+    int fd = open(nome, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    CabecalhoInstantaneo cab;
+    struct stat st;
+    int ok = pread(fd, &cab, sizeof(cab), 0) == (ssize_t)sizeof(cab) && fstat(fd, &st) == 0 &&
+             memcmp(cab.magica, "DJKGRAFO", 8) == 0 && cab.versao == VERSAO_INSTANTANEO &&
+             cab.chave.tamanho == chave->tamanho && cab.n >= 1 && cab.arestas >= 0 &&
+             cab.num_components >= 0 && cab.num_components <= cab.n &&
+             cab.inicio_arestas == inicio_das_arestas(&cab) &&
+             st.st_size == cab.inicio_arestas + LINHA_CACHE + cab.arestas * (long long)sizeof(Edge);
+    int mesmo_mtime = cab.chave.mtime_s == chave->mtime_s && cab.chave.mtime_ns == chave->mtime_ns;
+    if (ok && (!mesmo_mtime || instantaneo_verificar()))
+    {
+        if (!*com_hash)
+            *com_hash = hash_da_fonte(fonte, chave);
+        ok = *com_hash && cab.chave.hash == chave->hash;
+    }
+    const int *prefixo = MAP_FAILED;
+    char *base = MAP_FAILED;
+    size_t tam_arestas = LINHA_CACHE + cab.arestas * sizeof(Edge);
+    if (ok)
+    {
+        prefixo = mmap(NULL, cab.inicio_arestas, PROT_READ, MAP_PRIVATE, fd, 0);
+        base = mmap(NULL, tam_arestas, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, cab.inicio_arestas);
+        ok = prefixo != MAP_FAILED && base != MAP_FAILED;
+    }
+    close(fd);
+    const int *graus = ok ? (const int *)((const char *)prefixo + sizeof(cab)) : NULL;
+    ok = ok && instantaneo_consistente(&cab, graus, (const Edge *)(base + LINHA_CACHE));
+    if (!ok)
+    {
+        if (prefixo != MAP_FAILED)
+            munmap((void *)prefixo, cab.inicio_arestas);
+        if (base != MAP_FAILED)
+            munmap(base, tam_arestas);
+        return 0;
+    }
+    madvise(base, tam_arestas, MADV_WILLNEED);
+
+    // O trecho mapeado passa a ser um bloco de alocar(): páginas normais,
+    // desmapeado por liberar()
+    CabecalhoBloco *bloco = (CabecalhoBloco *)base;
+    bloco->mapeado = tam_arestas;
+    bloco->bytes = cab.arestas * sizeof(Edge);
+    bloco->tipo = PAGINAS_NORMAIS;
+    bloco->categoria = MEMORIA_GRAFO;
+    __atomic_add_fetch(&bytes_por_pagina[PAGINAS_NORMAIS], (long long)bloco->bytes, __ATOMIC_RELAXED);
+    contabilizar(MEMORIA_GRAFO, bloco->bytes);
+
+    init_graph(g, cab.n);
+    g->edge_pool = (Edge *)(base + LINHA_CACHE);
+    long long k = 0;
+    for (int u = 0; u < cab.n; u++)
+    {
+        g->vertices[u].edges = g->edge_pool + k;
+        g->vertices[u].edge_count = graus[u];
+        k += graus[u];
+    }
+    g->m = cab.m;
+    g->min_weight = cab.min_weight;
+    g->max_weight = cab.max_weight;
+    g->directed = cab.directed;
+    if (cab.num_components > 0)
+    {
+        const int *p = graus + cab.n;
+        g->num_components = cab.num_components;
+        g->component = copiar_vetor(p, cab.n);
+        g->component_start = copiar_vetor(p + cab.n, cab.num_components + 1);
+        g->component_vertices = copiar_vetor(p + cab.n + cab.num_components + 1, cab.n);
+        g->local_index = copiar_vetor(p + 2LL * cab.n + cab.num_components + 1, cab.n);
+    }
+    munmap((void *)prefixo, cab.inicio_arestas);
 
-    free(heap.nodes);
-    free(heap.dist);
-    free(pos);
-    free(visited);
-
-    return dist;
+    // Só o mtime mudou: grava o novo no cabeçalho para não recalcular o hash
+    // na próxima carga
+    if (!mesmo_mtime && (fd = open(nome, O_WRONLY)) >= 0)
+    {
+        if (pwrite(fd, chave, sizeof(*chave), offsetof(CabecalhoInstantaneo, chave)) != (ssize_t)sizeof(*chave))
+            fprintf(stderr, "Não foi possível atualizar o cabeçalho de %s\n", nome);
+        close(fd);
+    }
+    return 1;
 }
 
-double mean(double *arr, int n)
+// Grava em nome.tmp e renomeia, para que uma carga concorrente nunca veja um
+// instantâneo pela metade. Só grafos compactados (arestas em ordem no
+// edge_pool) são gravados.
+static int salvar_instantaneo(const char *nome, const ChaveFonte *chave, const Graph *g)
 {
-    double s = 0;
-    for (int i = 0; i < n; i++)
-        s += arr[i];
-    return s / n;
-}
+    CabecalhoInstantaneo cab;
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.magica, "DJKGRAFO", 8);
+    cab.versao = VERSAO_INSTANTANEO;
+    cab.directed = g->directed;
+    cab.chave = *chave;
+    cab.n = g->n;
+    cab.num_components = g->component ? g->num_components : 0;
+    cab.m = g->m;
+    cab.min_weight = g->min_weight;
+    cab.max_weight = g->max_weight;
+    for (int u = 0; u < g->n; u++)
+    {
+        if (g->vertices[u].edges != g->edge_pool + cab.arestas && g->vertices[u].edge_count > 0)
+            return 0;
+        cab.arestas += g->vertices[u].edge_count;
+    }
+    cab.inicio_arestas = inicio_das_arestas(&cab);
 
-double stddev(double *arr, int n, double m)
-{
-    double s = 0;
-    for (int i = 0; i < n; i++)
-        s += (arr[i] - m) * (arr[i] - m);
-    return sqrt(s / n);
+    char temporario[320];
+    snprintf(temporario, sizeof(temporario), "%s.%d.tmp", nome, (int)getpid());
+    FILE *f = fopen(temporario, "wb");
+    if (!f)
+        return 0;
+    int ok = fwrite(&cab, sizeof(cab), 1, f) == 1;
+    for (int u = 0; ok && u < g->n; u++)
+        ok = fwrite(&g->vertices[u].edge_count, sizeof(int), 1, f) == 1;
+    if (ok && cab.num_components > 0)
+        ok = fwrite(g->component, sizeof(int), g->n, f) == (size_t)g->n &&
+             fwrite(g->component_start, sizeof(int), cab.num_components + 1, f) == (size_t)cab.num_components + 1 &&
+             fwrite(g->component_vertices, sizeof(int), g->n, f) == (size_t)g->n &&
+             fwrite(g->local_index, sizeof(int), g->n, f) == (size_t)g->n;
+    static const char zeros[LINHA_CACHE];
+    for (long pos = ok ? ftell(f) : 0; ok && pos < cab.inicio_arestas + LINHA_CACHE;)
+    {
+        long passo = cab.inicio_arestas + LINHA_CACHE - pos;
+        passo = passo > LINHA_CACHE ? LINHA_CACHE : passo;
+        ok = fwrite(zeros, 1, passo, f) == (size_t)passo;
+        pos += passo;
+    }
+    if (ok && cab.arestas > 0)
+        ok = fwrite(g->edge_pool, sizeof(Edge), cab.arestas, f) == (size_t)cab.arestas;
+    ok = fclose(f) == 0 && ok;
+    if (ok)
+        ok = rename(temporario, nome) == 0;
+    if (!ok)
+        remove(temporario);
+    return ok;
 }
+#endif
 
-// Função utilitária para ler todo o conteúdo de um arquivo para um buffer
-char *read_file_to_buffer(const char *filename)
+// Carrega o grafo do arquivo, pelo instantâneo binário quando ele ainda
+// corresponde à origem; na primeira carga (ou se a origem mudou) lê o arquivo
+// e grava um instantâneo novo ao lado dele
+int load_graph(const char *filename, Graph *g)
 {
-    FILE *f = fopen(filename, "rb");
-    if (!f)
-        return NULL;
-    fseek(f, 0, SEEK_END);
-    long len = ftell(f);
-    rewind(f);
-    char *buf = malloc(len + 1);
-    if (!buf)
+    estado_instantaneo = INSTANTANEO_NENHUM;
+#ifdef __linux__
+    ChaveFonte chave;
+    char nome[300];
+    snprintf(nome, sizeof(nome), "%s.grafo.bin", filename);
+    int com_hash = 0;
+    int com_instantaneo = instantaneo_ligado() && chave_da_fonte(filename, &chave);
+    if (com_instantaneo && carregar_instantaneo(nome, filename, &chave, &com_hash, g))
     {
-        fclose(f);
-        return NULL;
+        estado_instantaneo = INSTANTANEO_LIDO;
+        return 1;
     }
-    fread(buf, 1, len, f);
-    buf[len] = '\0';
-    fclose(f);
-    return buf;
+    if (!carregar_por_extensao(filename, g))
+        return 0;
+    if (com_instantaneo && !com_hash)
+        com_hash = hash_da_fonte(filename, &chave);
+    // A origem mudou durante a leitura ou o hash: o grafo lido pode não
+    // corresponder à chave, então não grava
+    ChaveFonte depois;
+    if (com_instantaneo && com_hash && chave_da_fonte(filename, &depois) && depois.tamanho == chave.tamanho &&
+        depois.mtime_s == chave.mtime_s && depois.mtime_ns == chave.mtime_ns && salvar_instantaneo(nome, &chave, g))
+        estado_instantaneo = INSTANTANEO_GRAVADO;
+    return 1;
+#else
+    return carregar_por_extensao(filename, g);
+#endif
 }
 
-// Carrega grafo no formato node-link do NetworkX
-static int id_to_index(int *id_to_idx, int n, int id)
+static void adicionar_vertice_lista(int **lista, int *count, int *capacity, int v)
 {
-    for (int i = 0; i < n; i++)
-        if (id_to_idx[i] == id)
-            return i;
-    return -1;
+    if (*count == *capacity)
+    {
+        *capacity = *capacity ? *capacity * 2 : 16;
+        *lista = realloc(*lista, *capacity * sizeof(int));
+    }
+    (*lista)[(*count)++] = v;
 }
 
-int load_graph_from_json(const char *filename, Graph *g)
+// Lê listas de origens e destinos (índices de vértices, a partir de 0):
+//   # comentário
+//   origens: 0 1 2
+//   destinos: 10 20 30
+int carregar_origens_destinos(const char *filename, int n, int **origens, int *num_origens, int **destinos, int *num_destinos)
 {
-    char *buffer = read_file_to_buffer(filename);
-    if (!buffer)
-        return 0;
-    cJSON *root = cJSON_Parse(buffer);
-    free(buffer);
-    if (!root)
+    FILE *f = fopen(filename, "r");
+    if (!f)
         return 0;
-
-    int directed = 1;
-    cJSON *directed_item = cJSON_GetObjectItem(root, "directed");
-    if (directed_item && cJSON_IsBool(directed_item))
-        directed = cJSON_IsTrue(directed_item);
-    else if (directed_item && cJSON_IsNumber(directed_item))
-        directed = directed_item->valueint;
-
-    cJSON *nodes = cJSON_GetObjectItem(root, "nodes");
-    cJSON *links = cJSON_GetObjectItem(root, "links");
-    if (!cJSON_IsArray(nodes) || !cJSON_IsArray(links))
+    int cap_origens = 0, cap_destinos = 0, modo = 0, ok = 1;
+    char token[64];
+    *origens = *destinos = NULL;
+    *num_origens = *num_destinos = 0;
+    while (fscanf(f, "%63s", token) == 1)
     {
-        cJSON_Delete(root);
+        if (token[0] == '#')
+        {
+            int c;
+            while ((c = fgetc(f)) != EOF && c != '\n')
+                ;
+        }
+        else if (strcmp(token, "origens:") == 0)
+            modo = 1;
+        else if (strcmp(token, "destinos:") == 0)
+            modo = 2;
+        else
+        {
+            char *fim;
+            long v = strtol(token, &fim, 10);
+            if (*fim != '\0' || v < 0 || v >= n || modo == 0)
+            {
+                ok = 0;
+                break;
+            }
+            if (modo == 1)
+                adicionar_vertice_lista(origens, num_origens, &cap_origens, (int)v);
+            else
+                adicionar_vertice_lista(destinos, num_destinos, &cap_destinos, (int)v);
+        }
+    }
+    fclose(f);
+    if (!ok || *num_origens == 0 || *num_destinos == 0)
+    {
+        free(*origens);
+        free(*destinos);
         return 0;
     }
-    int n = cJSON_GetArraySize(nodes);
-    init_graph(g, n);
+    return 1;
+}
 
-    int *id_to_idx = malloc(sizeof(int) * n);
-    for (int i = 0; i < n; i++)
+typedef struct
+{
+    Graph *g;
+    int peso;
+    int inicio;
+    int fim;
+} PreenchimentoCompleto;
+
+static void *preencher_completo(void *arg)
+{
+    PreenchimentoCompleto *p = arg;
+    int n = p->g->n;
+    for (int u = p->inicio; u < p->fim; u++)
     {
-        cJSON *node = cJSON_GetArrayItem(nodes, i);
-        int id = cJSON_GetObjectItem(node, "id")->valueint;
-        id_to_idx[i] = id;
-    }
-    for (int i = 0; i < cJSON_GetArraySize(links); i++)
-    {
-        cJSON *link = cJSON_GetArrayItem(links, i);
-        int src = cJSON_GetObjectItem(link, "source")->valueint;
-        int tgt = cJSON_GetObjectItem(link, "target")->valueint;
-        int w = 1;
-        cJSON *weight = cJSON_GetObjectItem(link, "weight");
-        if (weight && cJSON_IsNumber(weight))
-            w = weight->valueint;
-        int u = id_to_index(id_to_idx, n, src);
-        int v = id_to_index(id_to_idx, n, tgt);
-        if (u >= 0 && v >= 0)
-        {
-            add_edge(g, u, v, w);
-            if (!directed)
-                add_edge(g, v, u, w); // Adiciona aresta inversa se não-direcionado
-        }
+        AdjList *list = &p->g->vertices[u];
+        list->edges = p->g->edge_pool + (size_t)u * (n - 1);
+        for (int v = 0; v < n; v++)
+            if (v != u)
+                list->edges[list->edge_count++] = (Edge){v, p->peso};
     }
-    free(id_to_idx);
-    cJSON_Delete(root);
-    return 1;
+    return NULL;
 }
 
 void gerar_grafo_completo(Graph *g, int n, int peso)
 {
     init_graph(g, n);
-    for (int u = 0; u < n; u++)
+    g->directed = 0;
+    // Grau conhecido (n - 1, não-direcionado): as listas são escritas direto
+    // no bloco contíguo, sem passar por add_edge, em faixas de vértices
+    // paralelas (que também dividem as falhas de página do bloco)
+    size_t arcos = (size_t)n * (n - 1);
+    g->edge_pool = alocar((arcos > 0 ? arcos : 1) * sizeof(Edge), MEMORIA_GRAFO);
+    int nthreads = numero_de_threads();
+    if (nthreads > n)
+        nthreads = n > 0 ? n : 1;
+    pthread_t *threads = malloc(nthreads * sizeof(pthread_t));
+    PreenchimentoCompleto *faixas = malloc(nthreads * sizeof(PreenchimentoCompleto));
+    for (int t = 0; t < nthreads; t++)
+        faixas[t] = (PreenchimentoCompleto){g, peso, (int)((long long)n * t / nthreads), (int)((long long)n * (t + 1) / nthreads)};
+    for (int t = 1; t < nthreads; t++)
+        pthread_create(&threads[t], NULL, preencher_completo, &faixas[t]);
+    preencher_completo(&faixas[0]);
+    for (int t = 1; t < nthreads; t++)
+        pthread_join(threads[t], NULL);
+    free(threads);
+    free(faixas);
+    g->m = arcos;
+    if (arcos > 0)
     {
-        for (int v = u + 1; v < n; v++)
-        {
-            add_edge(g, u, v, peso);
-            add_edge(g, v, u, peso); // Não-direcionado
-        }
+        g->min_weight = peso;
+        g->max_weight = peso;
     }
+    compute_components(g);
+}
+
+// Linha do CSV de resultados: tempos, memória por fase e pico por categoria
+static void formatar_resultado(char *linha, size_t tamanho_linha, const char *tamanho, const char *caso, double media, double maximo, double minimo, double total, double desvio, const MedidaFase *fases, const long long *picos)
+{
+    snprintf(linha, tamanho_linha, "%s,%s,%.6f,%.6f,%.6f,%.6f,%.6f,%ld,%ld,%ld,%ld,%ld,%ld,%lld,%lld,%lld,%lld,%s/%s/%s\n",
+             tamanho, caso, media, maximo, minimo, total, desvio,
+             fases[0].pico_rss_kb, fases[0].falhas_menores + fases[0].falhas_maiores,
+             fases[1].pico_rss_kb, fases[1].falhas_menores + fases[1].falhas_maiores,
+             fases[2].pico_rss_kb, fases[2].falhas_menores + fases[2].falhas_maiores,
+             picos[MEMORIA_GRAFO], picos[MEMORIA_JSON], picos[MEMORIA_BUSCA], picos[NUM_CATEGORIAS],
+             fases[0].pico_da_fase ? "pico" : "variação", fases[1].pico_da_fase ? "pico" : "variação",
+             fases[2].pico_da_fase ? "pico" : "variação");
+}
+
+// Linhas gravadas antes de uma coluna nova existir ganham campos vazios até
+// o número de colunas do cabeçalho
+static void completar_colunas(char *linha, size_t tamanho_linha, int colunas)
+{
+    size_t len = strcspn(linha, "\r\n");
+    int campos = 1;
+    for (size_t i = 0; i < len; i++)
+        campos += linha[i] == ',';
+    for (; campos < colunas && len + 2 < tamanho_linha; campos++)
+        linha[len++] = ',';
+    linha[len++] = '\n';
+    linha[len] = '\0';
 }
 
-void salvar_resultado_csv(const char *filename, const char *tamanho, const char *caso, double media, double maximo, double minimo, double total, double desvio)
+void salvar_resultado_csv(const char *filename, const char *tamanho, const char *caso, double media, double maximo, double minimo, double total, double desvio, const MedidaFase *fases, const long long *picos)
 {
+    const char *cabecalho = "Tamanho,Caso,Tempo médio,Tempo máximo,Tempo mínimo,Tempo total,Desvio padrão,"
+                            "Pico RSS carga (kB),Falhas de página carga,Pico RSS construção (kB),Falhas de página construção,"
+                            "Pico RSS busca (kB),Falhas de página busca,Pico grafo (bytes),Pico JSON (bytes),Pico busca (bytes),Pico total (bytes),"
+                            "Medida de RSS (carga/construção/busca)\n";
     FILE *f = fopen(filename, "r");
     char linhas[100][512];
     int n = 0, found = 0, header_written = 0;
     if (f)
     {
-        while (fgets(linhas[n], sizeof(linhas[n]), f) && n < 100)
+        // Reserva espaço para o cabeçalho e para a linha nova
+        while (n < 98 && fgets(linhas[n], sizeof(linhas[n]), f))
         {
             if (n == 0 && strstr(linhas[0], "Tamanho,Caso"))
             {
@@ -310,7 +5750,7 @@ void salvar_resultado_csv(const char *filename, const char *tamanho, const char
                 sscanf(linhas[n], "%31[^,],%31[^,]", t, c);
                 if (strcmp(t, tamanho) == 0 && strcmp(c, caso) == 0)
                 {
-                    snprintf(linhas[n], sizeof(linhas[n]), "%s,%s,%.6f,%.6f,%.6f,%.6f,%.6f\n", tamanho, caso, media, maximo, minimo, total, desvio);
+                    formatar_resultado(linhas[n], sizeof(linhas[n]), tamanho, caso, media, maximo, minimo, total, desvio, fases, picos);
                     found = 1;
                 }
             }
@@ -318,15 +5758,24 @@ void salvar_resultado_csv(const char *filename, const char *tamanho, const char
         }
         fclose(f);
     }
+    // Cabeçalho sempre reescrito: arquivos antigos ganham as colunas novas e
+    // suas linhas são completadas com campos vazios
     if (!header_written)
     {
-        strcpy(linhas[0], "Tamanho,Caso,Tempo médio,Tempo máximo,Tempo mínimo,Tempo total,Desvio padrão\n");
-        n = n == 0 ? 1 : n;
+        for (int i = n; i > 0; i--)
+            strcpy(linhas[i], linhas[i - 1]);
+        n++;
         header_written = 1;
     }
+    strcpy(linhas[0], cabecalho);
+    int colunas = 1;
+    for (const char *c = cabecalho; *c; c++)
+        colunas += *c == ',';
+    for (int i = 1; i < n; i++)
+        completar_colunas(linhas[i], sizeof(linhas[i]), colunas);
     if (!found)
     {
-        snprintf(linhas[n], sizeof(linhas[n]), "%s,%s,%.6f,%.6f,%.6f,%.6f,%.6f\n", tamanho, caso, media, maximo, minimo, total, desvio);
+        formatar_resultado(linhas[n], sizeof(linhas[n]), tamanho, caso, media, maximo, minimo, total, desvio, fases, picos);
         n++;
     }
 
@@ -398,6 +5847,31 @@ void salvar_tempos_individuais_csv(const char *filename, const char *tamanho, co
     }
 }
 
+void salvar_tabela_csv(const char *filename, const int *origens, int ns, const int *destinos, int nt, const int *tabela)
+{
+    FILE *f = fopen(filename, "w");
+    if (!f)
+        return;
+    fprintf(f, "Origem");
+    for (int j = 0; j < nt; j++)
+        fprintf(f, ",%d", destinos[j]);
+    fprintf(f, "\n");
+    for (int i = 0; i < ns; i++)
+    {
+        fprintf(f, "%d", origens[i]);
+        for (int j = 0; j < nt; j++)
+        {
+            int d = tabela[(size_t)i * nt + j];
+            if (d == INF)
+                fprintf(f, ",inf");
+            else
+                fprintf(f, ",%d", d);
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+}
+
 void limpar_terminal()
 {
 #ifdef _WIN32
@@ -420,22 +5894,165 @@ void mostrar_menu()
     printf("[7] Grafo Grande (Melhor caso)\n");
     printf("[8] Grafo Grande (Caso médio)\n");
     printf("[9] Grafo Grande (Pior caso)\n");
-    printf("Escolha (0-9): ");
+    printf("[10] Arquivo de grafo (DIMACS .gr, METIS .graph, lista de arestas ou JSON)\n");
+    printf("Escolha (0-10): ");
+}
+
+void mostrar_menu_algoritmo()
+{
+    printf("\nEscolha o algoritmo:\n");
+    printf("[1] Dijkstra (heap binário)\n");
+    printf("[2] Delta-stepping paralelo\n");
+    printf("[3] SSSP dinâmico (lotes de inserções e remoções de arestas)\n");
+    printf("[4] Busca limitada (k vizinhos mais próximos)\n");
+    printf("[5] Tabela de distâncias muitos-para-muitos (origens/destinos de arquivo)\n");
+    printf("[6] k caminhos mais curtos (Yen)\n");
+    printf("[7] Dijkstra no núcleo contraído (sem folhas e cadeias de grau 2)\n");
+    printf("[8] Lote de consultas concorrentes (pool de threads com roubo de tarefas)\n");
+    printf("[9] Lote com origens repetidas e cache de árvores de caminhos mínimos\n");
+    printf("[10] Dijkstra multi-origem vetorizado (8 ou 16 origens por passada)\n");
+    printf("[11] Lote intercalado numa só thread (prefetch e troca de consulta, AMAC)\n");
+    printf("Escolha (1-11): ");
+}
+
+// Sorteia um lote de consultas origem-destino; uma em cada dez pede o SSSP completo
+void gerar_lote_consultas(Graph *g, Query *consultas, int tamanho)
+{
+    for (int i = 0; i < tamanho; i++)
+    {
+        consultas[i].source = rand() % g->n;
+        consultas[i].target = i % 10 == 0 ? -1 : rand() % g->n;
+        consultas[i].dist_out = NULL;
+    }
+}
+
+// Lote em que nove de cada dez consultas saem de um pequeno conjunto de origens
+// "quentes", como no tráfego real
+void gerar_lote_origens_repetidas(Graph *g, Query *consultas, int tamanho, int num_quentes)
+{
+    int *quentes = malloc(num_quentes * sizeof(int));
+    for (int k = 0; k < num_quentes; k++)
+        quentes[k] = rand() % g->n;
+    gerar_lote_consultas(g, consultas, tamanho);
+    for (int i = 0; i < tamanho; i++)
+        if (rand() % 10 != 0)
+            consultas[i].source = quentes[rand() % num_quentes];
+    free(quentes);
+}
+
+// Consultas intercaladas por thread no modo AMAC (DIJKSTRA_INTERCALACAO, padrão 4)
+int largura_intercalacao()
+{
+    const char *valor = getenv("DIJKSTRA_INTERCALACAO");
+    int largura = valor ? atoi(valor) : 4;
+    return largura > 0 ? largura : 4;
+}
+
+// Grau a partir do qual o Dijkstra divide a relaxação entre threads
+// (DIJKSTRA_GRAU_HUB, padrão 1024)
+int limiar_hubs()
+{
+    const char *valor = getenv("DIJKSTRA_GRAU_HUB");
+    int limiar = valor ? atoi(valor) : 1024;
+    return limiar > 0 ? limiar : 1024;
+}
+
+// Orçamento do cache de árvores em MiB (DIJKSTRA_CACHE_MB, padrão 64)
+size_t orcamento_cache()
+{
+    const char *mb = getenv("DIJKSTRA_CACHE_MB");
+    long valor = mb ? atol(mb) : 64;
+    return (size_t)(valor > 0 ? valor : 64) << 20;
+}
+
+// Sorteia um lote de inserções de arestas / reduções de peso
+void gerar_lote_insercoes(Graph *g, EdgeUpdate *lote, int tamanho)
+{
+    int peso_max = g->max_weight > 0 ? g->max_weight : 1;
+    for (int i = 0; i < tamanho; i++)
+    {
+        lote[i].u = rand() % g->n;
+        lote[i].v = rand() % g->n;
+        lote[i].weight = 1 + rand() % peso_max;
+    }
+}
+
+// Sorteia um lote de remoções / aumentos de peso de arestas existentes
+void gerar_lote_remocoes(Graph *g, EdgeUpdate *lote, int tamanho)
+{
+    for (int i = 0; i < tamanho; i++)
+    {
+        int u = rand() % g->n;
+        AdjList *list = &g->vertices[u];
+        lote[i].u = u;
+        lote[i].v = list->edge_count ? list->edges[rand() % list->edge_count].dest : rand() % g->n;
+        lote[i].weight = rand() % 2 ? EDGE_DELETED : g->max_weight + 1 + rand() % 10;
+    }
+}
+
+int comparar_distancias(int *a, int *b, int n)
+{
+    for (int i = 0; i < n; i++)
+        if (a[i] != b[i])
+            return 0;
+    return 1;
+}
+
+// Confere se o resultado da busca limitada são os vértices mais próximos
+int verificar_vizinhos(SparseSearch *ss, int *ref, int n, int k)
+{
+    char *incluido = calloc(n, sizeof(char));
+    int alcancaveis = 0, ok = 1, maior = 0;
+    for (int i = 0; i < ss->result_count; i++)
+    {
+        Neighbor *r = &ss->result[i];
+        if (ref[r->vertex] != r->dist || incluido[r->vertex])
+            ok = 0;
+        incluido[r->vertex] = 1;
+        if (r->dist > maior)
+            maior = r->dist;
+    }
+    for (int v = 0; v < n; v++)
+    {
+        if (ref[v] == INF)
+            continue;
+        alcancaveis++;
+        if (!incluido[v] && ref[v] < maior)
+            ok = 0;
+    }
+    if (ss->result_count != (alcancaveis < k ? alcancaveis : k))
+        ok = 0;
+    free(incluido);
+    return ok;
 }
 
 int main()
 {
+    cJSON_Hooks ganchos = {json_malloc, json_free};
+    cJSON_InitHooks(&ganchos);
+#ifdef __linux__
+    mkdir("src/results", 0755); // saídas geradas, fora do git
+#endif
+
     while (1)
     {
         int opcao;
         Graph g;
         const char *arquivo;
         const char *nome_grafo;
+        char caminho[256], nome_arquivo[300];
 
         mostrar_menu();
         scanf("%d", &opcao);
         limpar_terminal();
 
+        // Fases medidas: [0] carga do grafo, [1] construção das estruturas do
+        // algoritmo, [2] as repetições da busca
+        InicioFase uso;
+        MedidaFase fases[3];
+        zerar_picos_memoria();
+        iniciar_fase(&uso);
+
         if (opcao == 0)
         {
             printf("Programa finalizado!\n");
@@ -483,6 +6100,13 @@ int main()
             gerar_grafo_completo(&g, 5000, 1);
             arquivo = NULL;
             break;
+        case 10:
+            printf("Arquivo do grafo (ex.: USA-road-d.NY.gr): ");
+            scanf("%255s", caminho);
+            arquivo = caminho;
+            snprintf(nome_arquivo, sizeof(nome_arquivo), "📂 %s", caminho);
+            nome_grafo = nome_arquivo;
+            break;
         default:
             printf("Opção inválida!\n");
             continue;
@@ -490,17 +6114,207 @@ int main()
 
         if (arquivo != NULL)
         {
-            if (!load_graph_from_json(arquivo, &g))
+            if (!load_graph(arquivo, &g))
             {
                 fprintf(stderr, "Erro ao carregar o grafo %s\n", nome_grafo);
                 continue;
             }
+            if (estado_instantaneo == INSTANTANEO_LIDO)
+                printf("⚡ Grafo lido do instantâneo %s.grafo.bin\n", arquivo);
+            else if (estado_instantaneo == INSTANTANEO_GRAVADO)
+                printf("💾 Instantâneo do grafo gravado em %s.grafo.bin\n", arquivo);
+        }
+        encerrar_fase(&uso, &fases[0]);
+
+        int algoritmo;
+        mostrar_menu_algoritmo();
+        scanf("%d", &algoritmo);
+        if (algoritmo < 1 || algoritmo > 11)
+        {
+            printf("Opção inválida!\n");
+            free_graph(&g);
+            continue;
+        }
+        // O benchmark sorteia vértices; Yen e k-NN usam 0 e n - 1 como extremos
+        int minimo_vertices = algoritmo == 4 || algoritmo == 6 ? 2 : 1;
+        if (g.n < minimo_vertices)
+        {
+            printf("❌ O grafo %s tem %d vértice(s); este algoritmo precisa de pelo menos %d\n", nome_grafo, g.n, minimo_vertices);
+            free_graph(&g);
+            continue;
+        }
+        iniciar_fase(&uso);
+
+        const char *csv_resultados = "src/results/resultados_dijkstra_c.csv";
+        const char *csv_execucoes = "src/results/todas_execucoes_c.csv";
+        int delta = 0, threads = 0;
+        if (algoritmo == 2)
+        {
+            csv_resultados = "src/results/resultados_delta_stepping_c.csv";
+            csv_execucoes = "src/results/todas_execucoes_delta_stepping_c.csv";
+            delta = escolher_delta(&g);
+            threads = numero_de_threads();
+        }
+        DynamicSSSP dyn;
+        EdgeUpdate lote[5], lote_remocoes[5];
+        long long alterados = 0;
+        if (algoritmo == 3)
+        {
+            csv_resultados = "src/results/resultados_sssp_dinamico_c.csv";
+            csv_execucoes = "src/results/todas_execucoes_sssp_dinamico_c.csv";
+            dynamic_sssp_init(&dyn, &g, 0);
+        }
+        DijkstraWorkspace area;
+        EquipeHubs equipe;
+        int hubs = 0;
+        if (algoritmo == 1)
+        {
+            dijkstra_workspace_init(&area, g.n);
+            int limiar = limiar_hubs();
+            for (int v = 0; v < g.n; v++)
+                if (g.vertices[v].edge_count >= limiar)
+                    hubs++;
+            if (hubs > 0 && equipe_hubs_init(&equipe, numero_de_threads(), limiar))
+                area.equipe = &equipe;
+        }
+        SparseSearch busca;
+        int k_vizinhos = 100;
+        Path caminhos[5];
+        int k_caminhos = sizeof(caminhos) / sizeof(caminhos[0]), num_caminhos = 0;
+        if (algoritmo == 6)
+        {
+            csv_resultados = "src/results/resultados_k_caminhos_c.csv";
+            csv_execucoes = "src/results/todas_execucoes_k_caminhos_c.csv";
+            sparse_search_init(&busca, g.n);
+        }
+        if (algoritmo == 4)
+        {
+            csv_resultados = "src/results/resultados_knn_c.csv";
+            csv_execucoes = "src/results/todas_execucoes_knn_c.csv";
+            sparse_search_init(&busca, g.n);
+        }
+        ContractedGraph contraido;
+        if (algoritmo == 7)
+        {
+            double t0 = tempo_atual();
+            if (!contract_graph(&contraido, &g))
+            {
+                printf("A contração exige um grafo não direcionado!\n");
+                free_graph(&g);
+                continue;
+            }
+            printf("✂️ Núcleo com %d de %d vértices e %lld de %lld arcos (%d folhas removidas, %d cadeias) em %.6f s\n",
+                   contraido.core.n, g.n, contraido.core.m, g.m, contraido.peeled, contraido.num_chains,
+                   tempo_atual() - t0);
+            csv_resultados = "src/results/resultados_contracao_c.csv";
+            csv_execucoes = "src/results/todas_execucoes_contracao_c.csv";
+            dijkstra_workspace_init(&area, contraido.core.n);
+        }
+        int *origens = NULL, *destinos = NULL, num_origens = 0, num_destinos = 0;
+        long long assentados = 0;
+        if (algoritmo == 5)
+        {
+            char lista[256];
+            printf("Arquivo com origens e destinos (ex.: src/graphs/origens_destinos.txt): ");
+            scanf("%255s", lista);
+            if (!carregar_origens_destinos(lista, g.n, &origens, &num_origens, &destinos, &num_destinos))
+            {
+                fprintf(stderr, "Erro ao carregar origens e destinos de %s\n", lista);
+                free_graph(&g);
+                continue;
+            }
+            csv_resultados = "src/results/resultados_muitos_para_muitos_c.csv";
+            csv_execucoes = "src/results/todas_execucoes_muitos_para_muitos_c.csv";
+        }
+        BatchExecutor executor;
+        Query consultas[1000];
+        QueryResult respostas[1000];
+        int num_consultas = sizeof(consultas) / sizeof(consultas[0]);
+        long long roubos = 0;
+        SptCache cache;
+        int largura = 0;
+        if (algoritmo == 8 || algoritmo == 9 || algoritmo == 11)
+        {
+            // Lotes menores em grafos densos, para cada repetição ter custo parecido
+            long long por_consulta = g.m + g.n;
+            if (por_consulta * num_consultas > 10000000LL)
+                num_consultas = (int)(10000000LL / por_consulta) > 4 ? (int)(10000000LL / por_consulta) : 4;
+        }
+        if (algoritmo == 11)
+        {
+            csv_resultados = "src/results/resultados_intercalado_c.csv";
+            csv_execucoes = "src/results/todas_execucoes_intercalado_c.csv";
+            largura = largura_intercalacao();
+            gerar_lote_consultas(&g, consultas, num_consultas);
+        }
+        if (algoritmo == 8 || algoritmo == 9)
+        {
+            csv_resultados = "src/results/resultados_lote_consultas_c.csv";
+            csv_execucoes = "src/results/todas_execucoes_lote_consultas_c.csv";
+            threads = numero_de_threads();
+            batch_executor_init(&executor, &g, threads);
+            if (algoritmo == 9)
+            {
+                csv_resultados = "src/results/resultados_cache_arvores_c.csv";
+                csv_execucoes = "src/results/todas_execucoes_cache_arvores_c.csv";
+                spt_cache_init(&cache, g.n, orcamento_cache(), 0);
+                executor.cache = &cache;
+                gerar_lote_origens_repetidas(&g, consultas, num_consultas, 16);
+            }
+            else
+                gerar_lote_consultas(&g, consultas, num_consultas);
+            if (executor.replicas)
+                printf("🧭 %d nós NUMA: uma réplica do grafo por nó, threads presas ao seu nó\n", executor.topo.num_nodes);
+            else if (executor.topo.num_nodes > 1)
+                printf("🧭 %d nós NUMA: replicação desligada (DIJKSTRA_NUMA=desligado)\n", executor.topo.num_nodes);
+            else
+                printf("🧭 Um único nó NUMA: grafo compartilhado entre as threads\n");
         }
 
+        int origens_multi[64], num_origens_multi = sizeof(origens_multi) / sizeof(origens_multi[0]);
+        RelaxarFaixas nucleo_faixas;
+        const char *nome_nucleo = NULL;
+        int faixas = 0;
+        if (algoritmo == 10)
+        {
+            csv_resultados = "src/results/resultados_multi_origem_c.csv";
+            csv_execucoes = "src/results/todas_execucoes_multi_origem_c.csv";
+            for (int i = 0; i < num_origens_multi; i++)
+                origens_multi[i] = (int)((long long)i * g.n / num_origens_multi);
+            faixas = escolher_faixas(&nucleo_faixas, &nome_nucleo);
+        }
+
+        encerrar_fase(&uso, &fases[1]);
         int rep = 30;
-        printf("🚀 Executando Dijkstra no grafo %s (n = %d)\n", nome_grafo, g.n);
+        if (g.num_components > 1)
+            printf("🧩 %d componentes conexos; o da origem tem %d vértices\n", g.num_components,
+                   g.component_start[g.component[0] + 1] - g.component_start[g.component[0]]);
+        mostrar_paginas();
+        if (algoritmo == 11)
+            printf("🚀 Executando lotes de %d consultas intercaladas, %d por vez numa só thread, no grafo %s (n = %d)\n", num_consultas, largura, nome_grafo, g.n);
+        else if (algoritmo == 10)
+            printf("🚀 Executando Dijkstra multi-origem (%d origens, %d faixas %s) no grafo %s (n = %d)\n", num_origens_multi, faixas, nome_nucleo, nome_grafo, g.n);
+        else if (algoritmo == 8 || algoritmo == 9)
+            printf("🚀 Executando lotes de %d consultas com %d threads no grafo %s (n = %d)\n", num_consultas, threads, nome_grafo, g.n);
+        else if (algoritmo == 2)
+            printf("🚀 Executando Delta-stepping (Δ = %d, %d threads) no grafo %s (n = %d)\n", delta, threads, nome_grafo, g.n);
+        else if (algoritmo == 7)
+            printf("🚀 Executando Dijkstra no núcleo contraído do grafo %s (n = %d)\n", nome_grafo, g.n);
+        else if (algoritmo == 6)
+            printf("🚀 Buscando os %d caminhos mais curtos de 0 a %d no grafo %s (n = %d)\n", k_caminhos, g.n - 1, nome_grafo, g.n);
+        else if (algoritmo == 5)
+            printf("🚀 Calculando tabela %d x %d no grafo %s (n = %d)\n", num_origens, num_destinos, nome_grafo, g.n);
+        else if (algoritmo == 4)
+            printf("🚀 Buscando os %d vizinhos mais próximos no grafo %s (n = %d)\n", k_vizinhos, nome_grafo, g.n);
+        else if (algoritmo == 3)
+            printf("🚀 Aplicando lotes de %d inserções e %d remoções ao SSSP dinâmico no grafo %s (n = %d)\n", (int)(sizeof(lote) / sizeof(lote[0])), (int)(sizeof(lote_remocoes) / sizeof(lote_remocoes[0])), nome_grafo, g.n);
+        else if (algoritmo == 1 && area.equipe)
+            printf("🚀 Executando Dijkstra no grafo %s (n = %d), com a relaxação dos %d hubs (grau ≥ %d) dividida entre %d threads\n", nome_grafo, g.n, hubs, equipe.limiar, equipe.nthreads);
+        else
+            printf("🚀 Executando Dijkstra no grafo %s (n = %d)\n", nome_grafo, g.n);
         double *tempos = malloc(rep * sizeof(double));
         double t_max = 0.0, t_min = 1e9, t_total = 0.0;
+        int contador_llc = algoritmo == 1 ? abrir_contador_llc() : -1;
 
         // Determinar tamanho e caso antes do loop de repetição
         const char *tamanho = NULL;
@@ -517,9 +6331,23 @@ int main()
             caso = "Médio";
         else if (strstr(nome_grafo, "Pior"))
             caso = "Pior";
+        if (opcao == 10)
+        {
+            // Arquivo externo: a linha do CSV leva o nome do arquivo
+            const char *base = strrchr(caminho, '/');
+            tamanho = "Arquivo";
+            caso = base ? base + 1 : caminho;
+        }
 
+        iniciar_fase(&uso);
         for (int i = 0; i < rep; i++)
         {
+            if (algoritmo == 3)
+            {
+                gerar_lote_insercoes(&g, lote, sizeof(lote) / sizeof(lote[0]));
+                gerar_lote_remocoes(&g, lote_remocoes, sizeof(lote_remocoes) / sizeof(lote_remocoes[0]));
+            }
+            ligar_contador(contador_llc, 1);
 #ifdef __linux__
             struct timespec start, end;
             clock_gettime(CLOCK_MONOTONIC, &start);
@@ -527,7 +6355,43 @@ int main()
             struct timeval start, end;
             gettimeofday(&start, NULL);
 #endif
-            int *dist = dijkstra(&g, 0);
+            int *dist = NULL;
+            switch (algoritmo)
+            {
+            case 1:
+                dijkstra_workspace(&area, &g, 0);
+                break;
+            case 2:
+                dist = delta_stepping(&g, 0, delta, threads);
+                break;
+            case 3:
+                alterados += dynamic_sssp_insert(&dyn, lote, sizeof(lote) / sizeof(lote[0]));
+                alterados += dynamic_sssp_increase(&dyn, lote_remocoes, sizeof(lote_remocoes) / sizeof(lote_remocoes[0]));
+                break;
+            case 4:
+                knn_search(&busca, &g, 0, k_vizinhos);
+                break;
+            case 5:
+                dist = many_to_many(&g, origens, num_origens, destinos, num_destinos, &assentados);
+                break;
+            case 6:
+                free_paths(caminhos, num_caminhos);
+                num_caminhos = k_shortest_paths(&busca, &g, 0, g.n - 1, k_caminhos, caminhos);
+                break;
+            case 7:
+                dist = contracted_dijkstra(&contraido, &area, 0);
+                break;
+            case 8:
+            case 9:
+                roubos += batch_executor_run(&executor, consultas, num_consultas, respostas);
+                break;
+            case 11:
+                interleaved_queries(&g, consultas, num_consultas, respostas, largura);
+                break;
+            case 10:
+                dist = multi_source_dijkstra(&g, origens_multi, num_origens_multi);
+                break;
+            }
 #ifdef __linux__
             clock_gettime(CLOCK_MONOTONIC, &end);
             tempos[i] = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
@@ -535,6 +6399,7 @@ int main()
             gettimeofday(&end, NULL);
             tempos[i] = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
 #endif
+            ligar_contador(contador_llc, 0);
             free(dist);
             printf("  🔄 Repetição %2d: %.6f segundos\n", i + 1, tempos[i]);
             if (tempos[i] > t_max)
@@ -544,8 +6409,10 @@ int main()
             t_total += tempos[i];
         }
 
+        encerrar_fase(&uso, &fases[2]);
+
         // Salvar tempos individuais
-        salvar_tempos_individuais_csv("src/results/todas_execucoes_c.csv", tamanho, caso, tempos, rep);
+        salvar_tempos_individuais_csv(csv_execucoes, tamanho, caso, tempos, rep);
 
         double m = mean(tempos, rep);
         double s = stddev(tempos, rep, m);
@@ -553,10 +6420,208 @@ int main()
         double maximo = t_max;
         double minimo = t_min;
         double total = t_total;
-        salvar_resultado_csv("src/results/resultados_dijkstra_c.csv", tamanho, caso, m, maximo, minimo, total, s);
+        salvar_resultado_csv(csv_resultados, tamanho, caso, m, maximo, minimo, total, s, fases, memoria_pico);
 
         printf("📊 Tempo médio: %.6f s, Desvio padrão: %.6f s\n", m, s);
-        printf("⏱️ Tempo máximo: %.6f s, Tempo mínimo: %.6f s, Tempo total: %.6f s\n\n", t_max, t_min, t_total);
+        printf("⏱️ Tempo máximo: %.6f s, Tempo mínimo: %.6f s, Tempo total: %.6f s\n", t_max, t_min, t_total);
+        const double mib = 1024.0 * 1024.0;
+        printf("📦 Pico de memória: grafo %.2f MiB, JSON %.2f MiB, busca %.2f MiB, total %.2f MiB\n",
+               memoria_pico[MEMORIA_GRAFO] / mib, memoria_pico[MEMORIA_JSON] / mib, memoria_pico[MEMORIA_BUSCA] / mib, memoria_pico[NUM_CATEGORIAS] / mib);
+        const char *nomes_fases[] = {"carga", "construção", "busca"};
+        for (int f = 0; f < 3; f++)
+            printf("   %s: %s %.1f MiB, %ld falhas de página menores e %ld maiores\n", nomes_fases[f],
+                   fases[f].pico_da_fase ? "pico RSS" : "variação de RSS", fases[f].pico_rss_kb / 1024.0,
+                   fases[f].falhas_menores, fases[f].falhas_maiores);
+        printf("\n");
+
+        if (algoritmo == 2)
+        {
+            int *ref = dijkstra(&g, 0);
+            int *dist = delta_stepping(&g, 0, delta, threads);
+            if (comparar_distancias(ref, dist, g.n))
+                printf("✅ Distâncias idênticas às do dijkstra()\n");
+            else
+                printf("❌ Distâncias diferentes das do dijkstra()\n");
+            free(ref);
+            free(dist);
+        }
+        else if (algoritmo == 3)
+        {
+            int *ref = dijkstra(&g, 0);
+            printf("🔧 Média de %.1f vértices reparados por lote\n", (double)alterados / rep);
+            int ok = 1;
+            for (int v = 0; v < g.n; v++)
+                if (dyn.state[v].dist != ref[v])
+                    ok = 0;
+            if (ok)
+                printf("✅ Distâncias idênticas às do dijkstra() recalculado do zero\n");
+            else
+                printf("❌ Distâncias diferentes das do dijkstra() recalculado do zero\n");
+            free(ref);
+            dynamic_sssp_free(&dyn);
+        }
+        else if (algoritmo == 4)
+        {
+            int *ref = dijkstra(&g, 0);
+            if (verificar_vizinhos(&busca, ref, g.n, k_vizinhos))
+                printf("✅ Vizinhos e distâncias conferem com o dijkstra()\n");
+            else
+                printf("❌ Vizinhos diferentes dos obtidos pelo dijkstra()\n");
+            free(ref);
+            sparse_search_free(&busca);
+        }
+        else if (algoritmo == 5)
+        {
+            int *tabela = many_to_many(&g, origens, num_origens, destinos, num_destinos, &assentados);
+            int ok = 1;
+            for (int i = 0; i < num_origens && ok; i++)
+            {
+                int *ref = dijkstra(&g, origens[i]);
+                for (int j = 0; j < num_destinos; j++)
+                    if (ref[destinos[j]] != tabela[(size_t)i * num_destinos + j])
+                        ok = 0;
+                free(ref);
+            }
+            printf("🔎 %lld vértices assentados (contra %lld em %d buscas completas)\n", assentados, (long long)num_origens * g.n, num_origens);
+            if (ok)
+                printf("✅ Tabela idêntica à obtida com dijkstra() a partir de cada origem\n");
+            else
+                printf("❌ Tabela diferente da obtida com dijkstra() a partir de cada origem\n");
+            salvar_tabela_csv("src/results/tabela_distancias_c.csv", origens, num_origens, destinos, num_destinos, tabela);
+            free(tabela);
+            free(origens);
+            free(destinos);
+        }
+        else if (algoritmo == 6)
+        {
+            int *ref = dijkstra(&g, 0);
+            for (int i = 0; i < num_caminhos; i++)
+                printf("🛣️ Caminho %d: custo %d, %d vértices\n", i + 1, caminhos[i].cost, caminhos[i].length);
+            if (num_caminhos == 0 ? ref[g.n - 1] == INF : caminhos[0].cost == ref[g.n - 1])
+                printf("✅ Menor caminho confere com o dijkstra()\n");
+            else
+                printf("❌ Menor caminho diferente do obtido pelo dijkstra()\n");
+            free(ref);
+            free_paths(caminhos, num_caminhos);
+            sparse_search_free(&busca);
+        }
+        else if (algoritmo == 7)
+        {
+            // Confere origens no núcleo, em cadeias e em árvores penduradas
+            int ok = 1;
+            int origens_teste[] = {0, g.n / 3, g.n / 2, g.n - 1};
+            for (int i = 0; i < 4 && ok; i++)
+            {
+                int *ref = dijkstra(&g, origens_teste[i]);
+                int *dist = contracted_dijkstra(&contraido, &area, origens_teste[i]);
+                ok = comparar_distancias(ref, dist, g.n);
+                free(ref);
+                free(dist);
+            }
+            if (ok)
+                printf("✅ Distâncias idênticas às do dijkstra() no grafo original\n");
+            else
+                printf("❌ Distâncias diferentes das do dijkstra() no grafo original\n");
+            dijkstra_workspace_free(&area);
+            contracted_graph_free(&contraido);
+        }
+        else if (algoritmo == 10)
+        {
+            int *tabela = multi_source_dijkstra(&g, origens_multi, num_origens_multi);
+            int ok = 1;
+            for (int i = 0; i < num_origens_multi && ok; i++)
+            {
+                int *ref = dijkstra(&g, origens_multi[i]);
+                ok = comparar_distancias(ref, tabela + (size_t)i * g.n, g.n);
+                free(ref);
+            }
+            if (ok)
+                printf("✅ Distâncias de todas as origens idênticas às do dijkstra()\n");
+            else
+                printf("❌ Distâncias diferentes das do dijkstra() para alguma origem\n");
+            free(tabela);
+        }
+        else if (algoritmo == 8 || algoritmo == 9 || algoritmo == 11)
+        {
+            // Confere uma amostra das respostas, na ordem de submissão
+            int ok = 1;
+            for (int i = 0; i < num_consultas && ok; i += 50)
+            {
+                int *ref = dijkstra(&g, consultas[i].source);
+                if (consultas[i].target >= 0)
+                    ok = respostas[i].dist == ref[consultas[i].target];
+                else
+                {
+                    int maior = 0;
+                    for (int v = 0; v < g.n; v++)
+                        if (ref[v] != INF && ref[v] > maior)
+                            maior = ref[v];
+                    ok = respostas[i].dist == maior;
+                }
+                free(ref);
+            }
+            if (algoritmo == 11)
+                printf("⚡ %.0f consultas/s numa thread, %d consultas intercaladas\n", num_consultas / m, largura);
+            else
+                printf("⚡ %.0f consultas/s com %d threads (%.1f roubos por lote)\n", num_consultas / m, threads, (double)roubos / rep);
+            if (algoritmo == 9)
+            {
+                long long consultas_cache = cache.hits + cache.misses;
+                printf("🗃️ Cache de %d árvores: %lld acertos e %lld faltas (%.1f%% de acertos), %lld despejos\n", cache.capacidade,
+                       cache.hits, cache.misses, 100.0 * cache.hits / (consultas_cache ? consultas_cache : 1), cache.evictions);
+            }
+            if (ok)
+                printf("✅ Respostas do lote conferem com o dijkstra()\n");
+            else
+                printf("❌ Respostas do lote diferentes das do dijkstra()\n");
+            if (algoritmo != 11)
+                batch_executor_free(&executor);
+            if (algoritmo == 9)
+                spt_cache_free(&cache);
+        }
+        else
+        {
+            int *pred = malloc(g.n * sizeof(int));
+            int *dist = dijkstra_pred(&g, 0, pred);
+            int ok = 1;
+            long long relaxacoes = 0;
+            for (int v = 0; v < g.n; v++)
+            {
+                if (workspace_dist(&area, v) != dist[v])
+                    ok = 0;
+                if (dist[v] != INF)
+                    relaxacoes += g.vertices[v].edge_count;
+            }
+            relaxacoes *= rep;
+            long long falhas = ler_contador(contador_llc);
+            if (falhas >= 0)
+                printf("🧠 %.4f falhas de LLC por relaxação (%lld falhas em %lld relaxações)\n", (double)falhas / (relaxacoes ? relaxacoes : 1), falhas, relaxacoes);
+            else
+                printf("🧠 Contador de falhas de LLC indisponível nesta máquina (%lld relaxações)\n", relaxacoes);
+            if (contador_llc >= 0)
+                close(contador_llc);
+            if (ok)
+                printf("✅ Área de trabalho reaproveitada confere com o dijkstra() alocado a cada chamada\n");
+            else
+                printf("❌ Área de trabalho reaproveitada difere do dijkstra() alocado a cada chamada\n");
+            long bytes = salvar_arvore_binaria("src/results/arvore_caminhos_c.bin", pred, dist, g.n, 0);
+            if (bytes >= 0)
+            {
+                printf("🌳 Árvore de caminhos mínimos salva em src/results/arvore_caminhos_c.bin (%ld bytes)\n", bytes);
+                if (conferir_arvore_salva(&g, "src/results/arvore_caminhos_c.bin", pred, dist, 0))
+                    printf("✅ Árvore relida confere e os caminhos de extract_path somam as distâncias\n");
+                else
+                    printf("❌ Árvore relida ou caminhos reconstruídos diferentes da busca\n");
+            }
+            if (area.equipe)
+            {
+                printf("🤝 %lld relaxações de hubs divididas entre %d threads por consulta\n", equipe.divididos / rep, equipe.nthreads);
+                equipe_hubs_free(&equipe);
+            }
+            dijkstra_workspace_free(&area);
+            free(pred);
+            free(dist);
+        }
 
         free(tempos);
         free_graph(&g);